@@ -0,0 +1,35 @@
+//
+// CancelToken.cpp
+//
+
+#include "CancelToken.h"
+
+CancelToken::CancelToken() {}
+
+CancelToken::CancelToken(double budget) {
+    if (budget > 0) {
+        hasDeadline = true;
+        deadline = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(budget));
+    }
+}
+
+CancelToken::CancelToken(chrono::steady_clock::time_point deadline) : hasDeadline(true), deadline(deadline) {}
+
+void CancelToken::cancel() {
+    cancelled.store(true, memory_order_relaxed);
+}
+
+bool CancelToken::poll() {
+    if (cancelled.load(memory_order_relaxed))
+        return true;
+    if (hasDeadline && chrono::steady_clock::now() >= deadline) {
+        cancel();
+        return true;
+    }
+    return false;
+}
+
+bool CancelToken::isCancelled() const {
+    return cancelled.load(memory_order_relaxed);
+}
+
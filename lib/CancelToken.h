@@ -0,0 +1,71 @@
+//
+// CancelToken.h
+//
+
+#ifndef CAL_PROJ_CANCELTOKEN_H
+#define CAL_PROJ_CANCELTOKEN_H
+
+#include <atomic>
+#include <chrono>
+
+using namespace std;
+
+#define CANCEL_CHECK_INTERVAL 256   // settled vertices (or iterations) between two looks at the clock
+
+/**
+ * Pedido de interrupção de uma pesquisa ou heurística, feito por outra thread (cancel) ou por um prazo.
+ *
+ * As pesquisas recebem um apontador para o token (nullptr para correrem até ao fim) e chamam shouldStop a cada
+ * vertex fixado, que só consulta o relógio a cada CANCEL_CHECK_INTERVAL chamadas. Uma pesquisa interrompida
+ * deixa as distâncias a meio; quem a chamou vê que foi interrompida com isCancelled.
+ */
+class CancelToken {
+public:
+    /**
+     * Token sem prazo, só interrompido por cancel.
+     */
+    CancelToken();
+
+    /**
+     * @param budget tempo disponível, em segundos a partir de agora (0 ou menos para não ter prazo)
+     */
+    explicit CancelToken(double budget);
+
+    /**
+     * @param deadline instante a partir do qual as pesquisas devem parar
+     */
+    explicit CancelToken(chrono::steady_clock::time_point deadline);
+
+    void cancel();
+
+    /**
+     * Consulta o relógio e marca o token como cancelado se o prazo tiver passado.
+     *
+     * @return true se as pesquisas devem parar.
+     */
+    bool poll();
+
+    /**
+     * @return true se o token foi cancelado ou uma pesquisa viu o prazo passar (não consulta o relógio).
+     */
+    bool isCancelled() const;
+
+private:
+    atomic<bool> cancelled{false};
+    bool hasDeadline = false;
+    chrono::steady_clock::time_point deadline;
+};
+
+/**
+ * Chamada pelos ciclos das pesquisas a cada vertex fixado (ou iteração).
+ *
+ * @param cancel token da pesquisa, nullptr se não puder ser interrompida
+ * @param counter contador da própria pesquisa, começado a 0
+ *
+ * @return true se a pesquisa deve parar.
+ */
+inline bool shouldStop(CancelToken *cancel, unsigned &counter) {
+    return cancel != nullptr && ++counter % CANCEL_CHECK_INTERVAL == 0 && cancel->poll();
+}
+
+#endif //CAL_PROJ_CANCELTOKEN_H
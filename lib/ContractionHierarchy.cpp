@@ -0,0 +1,324 @@
+//
+// ContractionHierarchy.cpp
+//
+
+#include <thread>
+#include <functional>
+#include "ContractionHierarchy.h"
+
+#define WITNESS_SETTLE_LIMIT 500
+
+typedef pair<double, unsigned> QueueEntry;
+typedef priority_queue<QueueEntry, vector<QueueEntry>, greater<QueueEntry>> MinQueue;
+
+/*
+ * Runs work(thread, item) for every item in [0, n), items are interleaved between the threads.
+ */
+static void parallelFor(unsigned n, unsigned threads, const function<void(unsigned, unsigned)> &work) {
+    if (threads == 0)
+        threads = max(1u, thread::hardware_concurrency());
+    threads = max(1u, min(threads, n));
+    vector<thread> workers;
+    for (unsigned t = 0; t < threads; t++)
+        workers.push_back(thread([&work, t, threads, n]() {
+            for (unsigned i = t; i < n; i += threads)
+                work(t, i);
+        }));
+    for (auto & w : workers)
+        w.join();
+}
+
+/*
+ * Adds the arc (to, w) to a dynamic adjacency list, keeping only the cheapest of parallel arcs.
+ */
+static void addArc(vector<pair<unsigned, double>> &arcs, unsigned to, double w) {
+    for (auto & a : arcs)
+        if (a.first == to) {
+            a.second = min(a.second, w);
+            return;
+        }
+    arcs.push_back(make_pair(to, w));
+}
+
+static void removeArc(vector<pair<unsigned, double>> &arcs, unsigned to) {
+    for (unsigned i = 0; i < arcs.size(); i++)
+        if (arcs[i].first == to) {
+            arcs[i] = arcs.back();
+            arcs.pop_back();
+            return;
+        }
+}
+
+ContractionHierarchy::ContractionHierarchy() : upFirst(1, 0), downFirst(1, 0) {}
+
+ContractionHierarchy::ContractionHierarchy(const StaticGraph &graph) {
+    unsigned n = graph.getNumVertex();
+    vector<vector<pair<unsigned, double>>> out(n), in(n);
+    for (unsigned v = 0; v < n; v++)
+        for (unsigned e = graph.edgeBegin(v); e < graph.edgeEnd(v); e++)
+            if (graph.getTarget(e) != v) {
+                addArc(out[v], graph.getTarget(e), graph.getWeight(e));
+                addArc(in[graph.getTarget(e)], v, graph.getWeight(e));
+            }
+
+    rank.assign(n, n);      // n means not contracted yet
+    vector<unsigned> contractedNeighbours(n, 0);
+    vector<vector<pair<unsigned, double>>> upArcs(n), downArcs(n);
+
+    //------------------WITNESS SEARCH-----------------------
+    vector<double> dist(n, INF);
+    vector<unsigned> touched;
+    auto shortcuts = [&](unsigned v, vector<pair<pair<unsigned, unsigned>, double>> &res) {
+        res.clear();
+        for (auto & inArc : in[v]) {
+            unsigned u = inArc.first;
+            double maxCost = 0;
+            for (auto & outArc : out[v])
+                if (outArc.first != u) maxCost = max(maxCost, inArc.second + outArc.second);
+            if (maxCost == 0) continue;
+
+            // local Dijkstra from u avoiding v, bounded by cost and by the number of settled vertices
+            MinQueue q;
+            dist[u] = 0;
+            touched.push_back(u);
+            q.push(QueueEntry(0, u));
+            unsigned settled = 0;
+            while (!q.empty() && settled < WITNESS_SETTLE_LIMIT) {
+                auto top = q.top();
+                q.pop();
+                if (top.first > dist[top.second]) continue;
+                if (top.first > maxCost) break;
+                settled++;
+                for (auto & a : out[top.second]) {
+                    if (a.first == v || top.first + a.second >= dist[a.first]) continue;
+                    if (dist[a.first] == INF) touched.push_back(a.first);
+                    dist[a.first] = top.first + a.second;
+                    q.push(QueueEntry(dist[a.first], a.first));
+                }
+            }
+            for (auto & outArc : out[v])
+                if (outArc.first != u && dist[outArc.first] > inArc.second + outArc.second)
+                    res.push_back(make_pair(make_pair(u, outArc.first), inArc.second + outArc.second));
+            for (auto t : touched)
+                dist[t] = INF;
+            touched.clear();
+        }
+    };
+    vector<pair<pair<unsigned, unsigned>, double>> added;
+    auto priority = [&](unsigned v) {
+        shortcuts(v, added);
+        return (double) added.size() - (double) (in[v].size() + out[v].size()) + contractedNeighbours[v];
+    };
+
+    //------------------CONTRACTION, LAZY UPDATES OF THE ORDER-----------------------
+    MinQueue order;
+    for (unsigned v = 0; v < n; v++)
+        order.push(QueueEntry(priority(v), v));
+    unsigned next = 0;
+    while (!order.empty()) {
+        unsigned v = order.top().second;
+        order.pop();
+        if (rank[v] != n) continue;
+        double p = priority(v);     // also leaves the shortcuts of v in added
+        if (!order.empty() && p > order.top().first) {
+            order.push(QueueEntry(p, v));
+            continue;
+        }
+
+        rank[v] = next++;
+        upArcs[v] = out[v];
+        downArcs[v] = in[v];
+        for (auto & a : out[v]) {
+            removeArc(in[a.first], v);
+            contractedNeighbours[a.first]++;
+        }
+        for (auto & a : in[v]) {
+            removeArc(out[a.first], v);
+            contractedNeighbours[a.first]++;
+        }
+        for (auto & s : added) {
+            addArc(out[s.first.first], s.first.second, s.second);
+            addArc(in[s.first.second], s.first.first, s.second);
+        }
+        numShortcuts += added.size();
+        out[v].clear();
+        in[v].clear();
+    }
+
+    //------------------UPWARD GRAPHS-----------------------
+    upFirst.push_back(0);
+    downFirst.push_back(0);
+    for (unsigned v = 0; v < n; v++) {
+        up.insert(up.end(), upArcs[v].begin(), upArcs[v].end());
+        down.insert(down.end(), downArcs[v].begin(), downArcs[v].end());
+        upFirst.push_back(up.size());
+        downFirst.push_back(down.size());
+    }
+}
+
+bool ContractionHierarchy::empty() const {
+    return rank.empty();
+}
+
+unsigned ContractionHierarchy::getNumVertex() const {
+    return rank.size();
+}
+
+unsigned ContractionHierarchy::getNumShortcuts() const {
+    return numShortcuts;
+}
+
+void ContractionHierarchy::upwardSearch(unsigned start, bool forward, double maxDist, vector<double> &dist, vector<unsigned> &settled) const {
+    const vector<unsigned> &first = forward ? upFirst : downFirst;
+    const vector<pair<unsigned, double>> &arcs = forward ? up : down;
+    MinQueue q;
+    settled.clear();
+    dist[start] = 0;
+    q.push(QueueEntry(0, start));
+    while (!q.empty()) {
+        auto top = q.top();
+        q.pop();
+        unsigned v = top.second;
+        if (top.first > dist[v]) continue;
+        if (top.first > maxDist) break;
+        settled.push_back(v);
+        for (unsigned a = first[v]; a < first[v + 1]; a++) {
+            double d = top.first + arcs[a].second;
+            if (d < dist[arcs[a].first]) {
+                dist[arcs[a].first] = d;
+                q.push(QueueEntry(d, arcs[a].first));
+            }
+        }
+    }
+}
+
+double ContractionHierarchy::query(unsigned source, unsigned target) const {
+    vector<double> forwardDist(rank.size(), INF), backwardDist(rank.size(), INF);
+    vector<unsigned> forwardSettled, backwardSettled;
+    upwardSearch(source, true, INF, forwardDist, forwardSettled);
+    upwardSearch(target, false, INF, backwardDist, backwardSettled);
+    double best = INF;
+    for (auto v : forwardSettled)
+        if (backwardDist[v] != INF)
+            best = min(best, forwardDist[v] + backwardDist[v]);
+    return best;
+}
+
+void ContractionHierarchy::fillBuckets(const vector<unsigned> &targets, double maxDist, unsigned threads, CancelToken *cancel,
+                                       vector<unsigned> &bucketFirst, vector<pair<unsigned, double>> &buckets) const {
+    unsigned n = rank.size();
+    if (threads == 0)
+        threads = max(1u, thread::hardware_concurrency());
+
+    // each thread keeps its own (vertex, target, dist) entries, merged afterwards without locks
+    vector<vector<pair<unsigned, pair<unsigned, double>>>> local(threads);
+    vector<vector<double>> dist(threads, vector<double>(n, INF));
+    vector<vector<unsigned>> settled(threads);
+    parallelFor(targets.size(), threads, [&](unsigned t, unsigned j) {
+        // upward searches are short, so the token is looked at once per search
+        if (cancel != nullptr && cancel->poll())
+            return;
+        upwardSearch(targets[j], false, maxDist, dist[t], settled[t]);
+        for (auto v : settled[t]) {
+            local[t].push_back(make_pair(v, make_pair(j, dist[t][v])));
+        }
+        for (auto v : settled[t])
+            dist[t][v] = INF;
+        // vertices reached but not settled still hold a tentative distance
+        for (unsigned a = 0; a < settled[t].size(); a++)
+            for (unsigned e = downFirst[settled[t][a]]; e < downFirst[settled[t][a] + 1]; e++)
+                dist[t][down[e].first] = INF;
+    });
+
+    bucketFirst.assign(n + 1, 0);
+    for (auto & entries : local)
+        for (auto & entry : entries)
+            bucketFirst[entry.first + 1]++;
+    for (unsigned v = 0; v < n; v++)
+        bucketFirst[v + 1] += bucketFirst[v];
+    buckets.resize(bucketFirst[n]);
+    vector<unsigned> pos(bucketFirst.begin(), bucketFirst.end() - 1);
+    for (auto & entries : local)
+        for (auto & entry : entries)
+            buckets[pos[entry.first]++] = entry.second;
+}
+
+vector<double> ContractionHierarchy::manyToMany(const vector<unsigned> &sources, const vector<unsigned> &targets, unsigned threads,
+                                                CancelToken *cancel) const {
+    unsigned n = rank.size(), m = targets.size();
+    vector<double> table(sources.size() * m, INF);
+    if (threads == 0)
+        threads = max(1u, thread::hardware_concurrency());
+
+    //------------------BACKWARD PHASE-----------------------
+    vector<unsigned> bucketFirst;
+    vector<pair<unsigned, double>> buckets;
+    fillBuckets(targets, INF, threads, cancel, bucketFirst, buckets);
+
+    //------------------FORWARD PHASE, EACH THREAD WRITES ITS OWN ROWS-----------------------
+    vector<vector<double>> dist(threads, vector<double>(n, INF));
+    vector<vector<unsigned>> settled(threads);
+    parallelFor(sources.size(), threads, [&](unsigned t, unsigned i) {
+        if (cancel != nullptr && cancel->poll())
+            return;
+        upwardSearch(sources[i], true, INF, dist[t], settled[t]);
+        double *row = &table[i * m];
+        for (auto v : settled[t])
+            for (unsigned b = bucketFirst[v]; b < bucketFirst[v + 1]; b++)
+                row[buckets[b].first] = min(row[buckets[b].first], dist[t][v] + buckets[b].second);
+        for (auto v : settled[t])
+            for (unsigned e = upFirst[v]; e < upFirst[v + 1]; e++)
+                dist[t][up[e].first] = INF;
+        for (auto v : settled[t])
+            dist[t][v] = INF;
+    });
+    return table;
+}
+
+vector<TableEntry> ContractionHierarchy::manyToManySparse(const vector<unsigned> &sources, const vector<unsigned> &targets, double maxDist, unsigned threads) const {
+    unsigned n = rank.size(), m = targets.size();
+    if (threads == 0)
+        threads = max(1u, thread::hardware_concurrency());
+
+    vector<unsigned> bucketFirst;
+    vector<pair<unsigned, double>> buckets;
+    fillBuckets(targets, maxDist, threads, nullptr, bucketFirst, buckets);
+
+    vector<vector<double>> dist(threads, vector<double>(n, INF));
+    vector<vector<double>> row(threads, vector<double>(m, INF));
+    vector<vector<unsigned>> settled(threads), reached(threads);
+    vector<vector<TableEntry>> local(threads);
+    parallelFor(sources.size(), threads, [&](unsigned t, unsigned i) {
+        upwardSearch(sources[i], true, maxDist, dist[t], settled[t]);
+        for (auto v : settled[t])
+            for (unsigned b = bucketFirst[v]; b < bucketFirst[v + 1]; b++) {
+                unsigned j = buckets[b].first;
+                if (row[t][j] == INF) reached[t].push_back(j);
+                row[t][j] = min(row[t][j], dist[t][v] + buckets[b].second);
+            }
+        for (auto j : reached[t]) {
+            if (row[t][j] <= maxDist) {
+                TableEntry entry;
+                entry.source = i;
+                entry.target = j;
+                entry.dist = row[t][j];
+                local[t].push_back(entry);
+            }
+            row[t][j] = INF;
+        }
+        reached[t].clear();
+        for (auto v : settled[t])
+            for (unsigned e = upFirst[v]; e < upFirst[v + 1]; e++)
+                dist[t][up[e].first] = INF;
+        for (auto v : settled[t])
+            dist[t][v] = INF;
+    });
+
+    vector<TableEntry> res;
+    for (auto & entries : local)
+        res.insert(res.end(), entries.begin(), entries.end());
+    sort(res.begin(), res.end(), [](const TableEntry &a, const TableEntry &b) {
+        return a.source < b.source || (a.source == b.source && a.target < b.target);
+    });
+    return res;
+}
@@ -0,0 +1,81 @@
+//
+// ContractionHierarchy.h
+//
+
+#ifndef CAL_PROJ_CONTRACTIONHIERARCHY_H
+#define CAL_PROJ_CONTRACTIONHIERARCHY_H
+
+#include "StaticGraph.h"
+
+/**
+ * Entrada de uma tabela de distâncias esparsa.
+ */
+struct TableEntry {
+    unsigned source;    // index in the sources vector
+    unsigned target;    // index in the targets vector
+    double dist;
+};
+
+/**
+ * Contraction hierarchy de um StaticGraph, usada para calcular tabelas de distâncias muitos-para-muitos.
+ *
+ * Os vertices são contraídos por ordem de importância (diferença de arestas), acrescentando atalhos sempre
+ * que uma pesquisa de testemunhas limitada não encontra um caminho alternativo. No fim, cada vertex guarda
+ * apenas as arestas para vertices mais importantes, nos dois sentidos, pelo que todas as pesquisas são
+ * pesquisas "para cima" que visitam poucas centenas de vertices.
+ */
+class ContractionHierarchy {
+public:
+    ContractionHierarchy();
+
+    explicit ContractionHierarchy(const StaticGraph &graph);
+
+    bool empty() const;
+
+    unsigned getNumVertex() const;
+
+    unsigned getNumShortcuts() const;
+
+    /**
+     * Distância mais curta entre dois vertices (índices no StaticGraph).
+     */
+    double query(unsigned source, unsigned target) const;
+
+    /**
+     * Tabela de distâncias muitos-para-muitos pelo algoritmo de buckets: uma pesquisa para trás a partir
+     * de cada destino deixa a sua distância em cada vertex visitado, e uma pesquisa para a frente a partir
+     * de cada origem só tem de percorrer os buckets dos vertices que visita.
+     * As duas fases são divididas por várias threads.
+     *
+     * @param sources índices das origens
+     * @param targets índices dos destinos
+     * @param threads número de threads (0 para usar todos os cores)
+     * @param cancel token que pode interromper o cálculo, deixando a tabela incompleta (nullptr para correr até ao fim)
+     *
+     * @return tabela densa sources.size() x targets.size(), por linhas (INF se não houver caminho).
+     */
+    vector<double> manyToMany(const vector<unsigned> &sources, const vector<unsigned> &targets, unsigned threads = 0,
+                              CancelToken *cancel = nullptr) const;
+
+    /**
+     * Versão esparsa de manyToMany: apenas os pares a uma distância não superior a maxDist, o que também
+     * limita as pesquisas.
+     *
+     * @return entradas ordenadas por origem e destino.
+     */
+    vector<TableEntry> manyToManySparse(const vector<unsigned> &sources, const vector<unsigned> &targets, double maxDist, unsigned threads = 0) const;
+
+private:
+    void upwardSearch(unsigned start, bool forward, double maxDist, vector<double> &dist, vector<unsigned> &settled) const;
+    void fillBuckets(const vector<unsigned> &targets, double maxDist, unsigned threads, CancelToken *cancel,
+                     vector<unsigned> &bucketFirst, vector<pair<unsigned, double>> &buckets) const;
+
+    vector<unsigned> rank;                  // contraction order of each vertex
+    vector<unsigned> upFirst;               // forward edges to more important vertices: [upFirst[v], upFirst[v+1])
+    vector<pair<unsigned, double>> up;
+    vector<unsigned> downFirst;             // reversed edges from more important vertices: [downFirst[v], downFirst[v+1])
+    vector<pair<unsigned, double>> down;
+    unsigned numShortcuts = 0;
+};
+
+#endif //CAL_PROJ_CONTRACTIONHIERARCHY_H
@@ -0,0 +1,63 @@
+//
+// CostMatrix.cpp
+//
+
+#include <algorithm>
+#include "CostMatrix.h"
+
+CostMatrix::CostMatrix() {}
+
+CostMatrix::CostMatrix(const StaticGraph &graph, const vector<Vertex<Node> *> &points, CancelToken *cancel) : points(points) {
+    vector<unsigned> positions;
+    for (auto p : points)
+        positions.push_back(p->posAtVec);
+    costs = graph.distanceTable(positions, positions, true, cancel);
+}
+
+CostMatrix::CostMatrix(const vector<Vertex<Node> *> &points) : points(points), costs(points.size() * points.size(), INF) {
+    for (unsigned i = 0; i < points.size(); i++)
+        costs[(size_t) i * points.size() + i] = 0;
+}
+
+unsigned CostMatrix::addPoint(Vertex<Node> *point, const StaticGraph &graph, const StaticGraph &reverse,
+                              vector<unsigned> &forwardParent, vector<unsigned> &backwardParent, CancelToken *cancel) {
+    unsigned n = points.size();
+    vector<double> grown((size_t) (n + 1) * (n + 1), INF);
+    for (unsigned i = 0; i < n; i++)
+        copy(costs.begin() + (size_t) i * n, costs.begin() + (size_t) (i + 1) * n, grown.begin() + (size_t) i * (n + 1));
+    costs.swap(grown);
+    points.push_back(point);
+
+    vector<double> dist;
+    RelaxKernel kernel = getRelaxKernel();
+    graph.shortestPath(point->posAtVec, dist, forwardParent, kernel, cancel);
+    for (unsigned j = 0; j <= n; j++)
+        costs[(size_t) n * (n + 1) + j] = dist[points[j]->posAtVec];
+    reverse.shortestPath(point->posAtVec, dist, backwardParent, kernel, cancel);
+    for (unsigned i = 0; i < n; i++)
+        costs[(size_t) i * (n + 1) + n] = dist[points[i]->posAtVec];
+    return n;
+}
+
+unsigned CostMatrix::size() const {
+    return points.size();
+}
+
+double CostMatrix::cost(unsigned i, unsigned j) const {
+    return costs[(size_t) i * points.size() + j];
+}
+
+void CostMatrix::setCost(unsigned i, unsigned j, double cost) {
+    costs[(size_t) i * points.size() + j] = cost;
+}
+
+Vertex<Node> *CostMatrix::getPoint(unsigned i) const {
+    return points[i];
+}
+
+int CostMatrix::indexOf(const Vertex<Node> *point) const {
+    for (unsigned i = 0; i < points.size(); i++)
+        if (points[i] == point)
+            return i;
+    return -1;
+}
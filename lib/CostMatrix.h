@@ -0,0 +1,70 @@
+//
+// CostMatrix.h
+//
+
+#ifndef CAL_PROJ_COSTMATRIX_H
+#define CAL_PROJ_COSTMATRIX_H
+
+#include <vector>
+#include "StaticGraph.h"
+
+using namespace std;
+
+/**
+ * Matriz dos custos das pernas entre os pontos de um serviço (garagem, pontos de recolha e fábrica), usada pelas
+ * heurísticas de ordenação para não repetirem pesquisas no grafo. cost(i, j) é o comprimento do caminho mais curto
+ * do ponto i para o ponto j.
+ */
+class CostMatrix {
+public:
+    CostMatrix();
+
+    /**
+     * Calcula a matriz de todos os pontos para todos com StaticGraph::distanceTable.
+     *
+     * @param graph StaticGraph do grafo dos pontos
+     * @param points vertices dos pontos
+     * @param cancel token que pode interromper o cálculo, deixando custos a INF (nullptr para correr até ao fim)
+     */
+    CostMatrix(const StaticGraph &graph, const vector<Vertex<Node> *> &points, CancelToken *cancel = nullptr);
+
+    /**
+     * Matriz sem pesquisas: os custos começam a INF (0 na diagonal) e são dados com setCost.
+     */
+    explicit CostMatrix(const vector<Vertex<Node> *> &points);
+
+    /**
+     * Acrescenta um ponto calculando só a sua linha e a sua coluna: uma pesquisa a partir do ponto no grafo e
+     * outra no grafo invertido.
+     *
+     * @param point vertex do ponto
+     * @param graph StaticGraph do grafo
+     * @param reverse graph.reversed()
+     * @param forwardParent recebe o vertex anterior de cada vertex nos caminhos do ponto para os outros
+     * @param backwardParent recebe o vertex seguinte de cada vertex nos caminhos dos outros para o ponto
+     * @param cancel token que pode interromper as pesquisas, deixando custos a INF (nullptr para correr até ao fim)
+     *
+     * @return índice do ponto.
+     */
+    unsigned addPoint(Vertex<Node> *point, const StaticGraph &graph, const StaticGraph &reverse,
+                      vector<unsigned> &forwardParent, vector<unsigned> &backwardParent, CancelToken *cancel = nullptr);
+
+    unsigned size() const;
+
+    double cost(unsigned i, unsigned j) const;
+
+    void setCost(unsigned i, unsigned j, double cost);
+
+    Vertex<Node> *getPoint(unsigned i) const;
+
+    /**
+     * @return índice do ponto com o vertex dado, -1 se não estiver na matriz.
+     */
+    int indexOf(const Vertex<Node> *point) const;
+
+private:
+    vector<Vertex<Node> *> points;
+    vector<double> costs;       // by rows
+};
+
+#endif //CAL_PROJ_COSTMATRIX_H
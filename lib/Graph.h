@@ -5,6 +5,7 @@
 #define GRAPH_H_
 
 #include <vector>
+#include <cstdint>
 #include <iostream>
 #include <queue>
 #include <list>
@@ -13,14 +14,20 @@
 #include <algorithm>
 #include "MutablePriorityQueue.h"
 #include <unordered_map>
+#include <thread>
+#include <functional>
+#include <memory>
 
 #include "Node.h"
+#include "TimeProfiles.h"
+#include "CancelToken.h"
 
 using namespace std;
 
 template <class T> class Edge;
 template <class T> class Graph;
 template <class T> class Vertex;
+template <class T> class Road;
 
 #define INF std::numeric_limits<double>::max()
 
@@ -32,10 +39,13 @@ template <class T> class Vertex;
 template <class T>
 class Vertex {
 	T info;						// content of the vertex
-	vector<Edge<T> > adj;		// outgoing edges
+	vector<uint32_t> adj;		// outgoing edges: index of the road in roadSet << 1 | 1 if hidden in the viewer
+	vector<Road<T> > *roadSet = nullptr;    // the graph's roads
 	
 	double dist = 0;            // dist
+	double estimate = 0;        // A* lower bound to the target (0 outside A*)
 	Vertex<T> *path = NULL;     // path
+	int pathEdge = -1;          // index (see getEdge) in path's edges of the edge used to reach this vertex
 	int queueIndex = 0; 		// required by MutablePriorityQueue
 
 	bool visited = false;		// auxiliary field
@@ -50,11 +60,15 @@ public:
 	void setInfo(T newinfo);
 	double getDist() const;
 	Vertex *getPath() const;
+	int getPathEdge() const;
 	bool getVisited(){return visited;}
 	void setVisited(bool v){visited=v;}
     vector<Edge<T> > getAdj() const;
+    unsigned getNumEdges() const;
+    Edge<T> getEdge(unsigned i) const;
     void removeEdge(int i);
-    size_t posAtVec;
+    void setEdgeProfile(int i, int profile);
+    size_t posAtVec;            // position of the vertex in the graph's vertexSet
 
 	bool operator<(Vertex<T> & vertex) const; // // required by MutablePriorityQueue
 	friend class Graph<T>;
@@ -68,31 +82,64 @@ Vertex<T>::Vertex(T in): info(in) {}
 
 template <class T>
 vector<Edge<T> > Vertex<T>::getAdj() const {
-    return adj;
+    vector<Edge<T> > res;
+    res.reserve(adj.size());
+    for (unsigned i = 0; i < adj.size(); i++)
+        res.push_back(getEdge(i));
+    return res;
+}
+
+template <class T>
+unsigned Vertex<T>::getNumEdges() const {
+    return adj.size();
+}
+
+/*
+ * Outgoing edge i, built from the road it goes along, without building the whole list.
+ */
+template <class T>
+Edge<T> Vertex<T>::getEdge(unsigned i) const {
+    const Road<T> &road = (*roadSet)[adj[i] >> 1];
+    Edge<T> e(road.other(this), road.weight, (adj[i] & 1) == 0);
+    e.profile = road.profile;
+    return e;
 }
 
 /*
  * Auxiliary function to add an outgoing edge to a vertex (this),
  * with a given destination vertex (d) and edge weight (w).
+ * The edge is a new one-way road, referenced only from this vertex.
  */
 template <class T>
 void Vertex<T>::addEdge(Vertex<T> *d, double w) {
-	adj.push_back(Edge<T>(d, w));
+    addEdge(d, w, true);
 }
 
 template <class T>
 void Vertex<T>::addEdge(Vertex<T> *dest, double w, bool display) {
-    adj.push_back(Edge<T>(dest, w, display));
+    adj.push_back(roadSet->size() << 1 | (display ? 0 : 1));
+    roadSet->push_back(Road<T>(this, dest, w));
 }
 
+/*
+ * Removing one direction of a two-way road leaves the other direction as a one-way road.
+ */
 template <class T>
 void Vertex<T>::removeEdge(int i) {
     adj.erase(adj.begin() + i);
 }
 
+/*
+ * The profile belongs to the road, so it applies to both directions.
+ */
+template <class T>
+void Vertex<T>::setEdgeProfile(int i, int profile) {
+    (*roadSet)[adj[i] >> 1].profile = profile;
+}
+
 template <class T>
 bool Vertex<T>::operator<(Vertex<T> & vertex) const {
-	return this->dist < vertex.dist;
+	return this->dist + this->estimate < vertex.dist + vertex.estimate;
 }
 
 template <class T>
@@ -110,6 +157,11 @@ Vertex<T> *Vertex<T>::getPath() const {
 	return this->path;
 }
 
+template <class T>
+int Vertex<T>::getPathEdge() const {
+	return this->pathEdge;
+}
+
 /********************** Edge  ****************************/
 
 template <class T>
@@ -117,6 +169,7 @@ class Edge {
 	Vertex<T> * dest;      // destination vertex
 	double weight;         // edge weight
 	bool displayGV;     //needed because we add the same edge twice and should only display 1
+	int profile = -1;      // index in the graph's TimeProfiles, -1 if the edge has a static cost
 
 public:
 	Edge(Vertex<T> *d, double w);
@@ -124,6 +177,7 @@ public:
 	Vertex<T>* getDest() {return dest;}
 	bool displayEdge(){return displayGV;}
 	double getWeight(){return weight;}
+	int getProfile(){return profile;}
 	friend class Graph<T>;
 	friend class Vertex<T>;
 };
@@ -134,11 +188,43 @@ template<class T>
 Edge<T>::Edge(Vertex<T> *d, double w, bool disp): dest(d), weight(w), displayGV(disp) {}
 
 
+/********************** Road  ****************************/
+
+/*
+ * Road segment stored once and referenced from the adjacency lists (Vertex::adj) of the ends it can be
+ * travelled from: both for a two-way road, only the origin for a one-way street. This replaces the two Edge
+ * copies per two-way road; Edge is still what the rest of the code sees, built on the fly by Vertex::getEdge.
+ * Only the xor of the addresses of the two ends is kept: from either end, the other one is ends ^ that end.
+ * The weight is kept in single precision, well below the precision of the maps.
+ */
+template <class T>
+class Road {
+	uintptr_t ends;
+	float weight;
+	int profile = -1;
+
+public:
+	Road(Vertex<T> *a, Vertex<T> *b, double w);
+	Vertex<T> *other(const Vertex<T> *v) const;
+	friend class Graph<T>;
+	friend class Vertex<T>;
+};
+
+template <class T>
+Road<T>::Road(Vertex<T> *a, Vertex<T> *b, double w): ends(reinterpret_cast<uintptr_t>(a) ^ reinterpret_cast<uintptr_t>(b)), weight(w) {}
+
+template <class T>
+Vertex<T> *Road<T>::other(const Vertex<T> *v) const {
+	return reinterpret_cast<Vertex<T> *>(ends ^ reinterpret_cast<uintptr_t>(v));
+}
+
+
 /*************************** Graph  **************************/
 
 template <class T>
 class Graph {
 	vector<Vertex<T> *> vertexSet;    // vertex set
+	shared_ptr<vector<Road<T> > > roads = make_shared<vector<Road<T> > >();    // shared by copies, like the vertices
     double ** W = nullptr; // dist
     int **P = nullptr; // path
     int findVertexIdx(const T &in) const;
@@ -146,8 +232,14 @@ class Graph {
 public:
 	Vertex<T> *findVertex(const T &in) const;
 	bool addVertex(const T &in);
+	Vertex<T> *addNewVertex(const T &in);
 	bool addEdge(const T &sourc, const T &dest, double w);
 	bool addEdge(const T &sourc, const T &dest, double w, bool disp);
+	bool addRoad(const T &sourc, const T &dest, double w);
+	void addRoad(Vertex<T> *v1, Vertex<T> *v2, double w);
+	void addRoads(const vector<pair<uint32_t, uint32_t> > &ends, const vector<double> &weights, unsigned threads = 0);
+	bool removeRoad(Vertex<T> *v1, Vertex<T> *v2);
+	unsigned getNumRoads() const;
 	int getNumVertex() const;
 	vector<Vertex<T> *> getVertexSet() const;
 	void setVertexSet(vector<Vertex<T> *> newSet);
@@ -157,10 +249,17 @@ public:
 
 	// Fp05 - single source
 	void unweightedShortestPath(const T &orig);
-	void dijkstraShortestPath(const T &orig);
-	void bellmanFordShortestPath(const T &orig);
+	void dijkstraShortestPath(const T &orig, CancelToken *cancel = nullptr);
+	void bellmanFordShortestPath(const T &orig, CancelToken *cancel = nullptr);
+	void timeDependentShortestPath(const T &orig, double departure, const TimeProfiles &profiles, CancelToken *cancel = nullptr);
+	void timeDependentAStar(const T &orig, const T &dest, double departure, const TimeProfiles &profiles, CancelToken *cancel = nullptr);
+	bool corridorShortestPath(const T &orig, const T &dest, double maxLength, CancelToken *cancel = nullptr);
+	vector<int> multiSourceShortestPath(const vector<T> &sources);
+	vector<Vertex<T> *> boundedShortestPath(const T &orig, double radius, const TimeProfiles *profiles = nullptr, double departure = 0);
+	vector<vector<T> > alternativeRoutes(const T &orig, const T &dest, unsigned k, double maxStretch = 1.3, double maxOverlap = 0.7);
 	vector<T> getPathTo(const T &origin, const T &dest) const;
     vector<T> getPath(const T &origin, const T &dest) const;
+    double appendPath(const Vertex<T> *dest, vector<uint32_t> &path) const;
     ~Graph();
 
 
@@ -179,8 +278,8 @@ template <class T>
 void Graph<T>::DepthFirstSearch(Vertex<T> *v, vector<Vertex<T>* > & accessible) const {
     v->visited = true;
     accessible.push_back(v);
-    for (auto & e : v->adj) {
-        auto w = e.dest;
+    for (unsigned j = 0; j < v->getNumEdges(); j++) {
+        auto w = v->getEdge(j).dest;
         if ( ! w->visited)
             DepthFirstSearch(w, accessible);
     }
@@ -199,6 +298,8 @@ vector<Vertex<T> *> Graph<T>::getVertexSet() const {
 template<class T>
 void Graph<T>::setVertexSet(vector<Vertex<T> *> newSet){
     this->vertexSet=newSet;
+    for (size_t i = 0; i < vertexSet.size(); i++)
+        vertexSet[i]->posAtVec = i;
 }
 
 
@@ -222,9 +323,22 @@ bool Graph<T>::addVertex(const T &in) {
 	if ( findVertex(in) != NULL)
 		return false;
 	vertexSet.push_back(new Vertex<T>(in));
+	vertexSet.back()->posAtVec = vertexSet.size() - 1;
+	vertexSet.back()->roadSet = roads.get();
 	return true;
 }
 
+/*
+ * Adds a vertex that the caller knows is not in the graph yet, without the linear search of addVertex.
+ */
+template <class T>
+Vertex<T> *Graph<T>::addNewVertex(const T &in) {
+	vertexSet.push_back(new Vertex<T>(in));
+	vertexSet.back()->posAtVec = vertexSet.size() - 1;
+	vertexSet.back()->roadSet = roads.get();
+	return vertexSet.back();
+}
+
 /*
  * Adds an edge to a graph (this), given the contents of the source and
  * destination vertices and the edge weight (w).
@@ -250,6 +364,103 @@ bool Graph<T>::addEdge(const T &sourc, const T &dest, double w, bool shouldDispl
     return true;
 }
 
+/*
+ * Adds a two-way road between the vertices with the given contents, stored only once.
+ * It is displayed in the sourc -> dest direction.
+ * Returns true if successful, and false if the source or destination vertex does not exist.
+ */
+template <class T>
+bool Graph<T>::addRoad(const T &sourc, const T &dest, double w) {
+    auto v1 = findVertex(sourc);
+    auto v2 = findVertex(dest);
+    if (v1 == NULL || v2 == NULL)
+        return false;
+    addRoad(v1, v2, w);
+    return true;
+}
+
+/*
+ * Same as above, for vertices already found (both must belong to this graph).
+ */
+template <class T>
+void Graph<T>::addRoad(Vertex<T> *v1, Vertex<T> *v2, double w) {
+    v1->addEdge(v2, w, true);
+    v2->adj.push_back(v1->adj.back() | 1);
+}
+
+/*
+ * Adds many two-way roads at once, given the positions in vertexSet of their ends, with the same result
+ * as calling addRoad for each of them in order. The roads are split into one chunk per thread: every chunk
+ * counts how many references it adds to each vertex, a prefix sum over the chunks gives each chunk the
+ * position where it writes in each adjacency list, and then all chunks fill the lists without locks.
+ */
+template <class T>
+void Graph<T>::addRoads(const vector<pair<uint32_t, uint32_t> > &ends, const vector<double> &weights, unsigned threads) {
+    if (threads == 0)
+        threads = max(1u, thread::hardware_concurrency());
+    size_t n = vertexSet.size(), m = ends.size(), first = roads->size();
+    threads = max((size_t) 1, min((size_t) threads, m));
+    roads->resize(first + m, Road<T>(nullptr, nullptr, 0));
+    vector<vector<uint32_t> > count(threads, vector<uint32_t>(n, 0));
+    auto parallel = [threads](const function<void(unsigned)> &work) {
+        vector<thread> workers;
+        for (unsigned t = 0; t < threads; t++)
+            workers.push_back(thread(work, t));
+        for (auto & w : workers)
+            w.join();
+    };
+
+    parallel([&](unsigned t) {
+        for (size_t i = m * t / threads; i < m * (t + 1) / threads; i++) {
+            (*roads)[first + i] = Road<T>(vertexSet[ends[i].first], vertexSet[ends[i].second], weights[i]);
+            count[t][ends[i].first]++;
+            count[t][ends[i].second]++;
+        }
+    });
+    parallel([&](unsigned t) {
+        for (size_t v = n * t / threads; v < n * (t + 1) / threads; v++) {
+            uint32_t total = vertexSet[v]->adj.size();
+            for (unsigned c = 0; c < threads; c++) {
+                uint32_t k = count[c][v];
+                count[c][v] = total;
+                total += k;
+            }
+            vertexSet[v]->adj.resize(total);
+        }
+    });
+    parallel([&](unsigned t) {
+        for (size_t i = m * t / threads; i < m * (t + 1) / threads; i++) {
+            vertexSet[ends[i].first]->adj[count[t][ends[i].first]++] = (first + i) << 1;
+            vertexSet[ends[i].second]->adj[count[t][ends[i].second]++] = (first + i) << 1 | 1;
+        }
+    });
+}
+
+/*
+ * Removes every edge between v1 and v2, in both directions.
+ * Returns false if there was none.
+ */
+template <class T>
+bool Graph<T>::removeRoad(Vertex<T> *v1, Vertex<T> *v2) {
+    bool removed = false;
+    for (int k = 0; k < 2; k++) {
+        Vertex<T> *v = k == 0 ? v1 : v2, *w = k == 0 ? v2 : v1;
+        for (unsigned j = 0; j < v->adj.size(); j++)
+            if ((*roads)[v->adj[j] >> 1].other(v) == w) {
+                v->adj.erase(v->adj.begin() + j--);
+                removed = true;
+            }
+    }
+    return removed;
+}
+
+/*
+ * Number of road segments stored, two-way or one-way, including removed ones.
+ */
+template <class T>
+unsigned Graph<T>::getNumRoads() const {
+    return roads->size();
+}
 
 /**************** Single Source Shortest Path algorithms ************/
 
@@ -259,6 +470,7 @@ void Graph<T>::unweightedShortestPath(const T &orig) {
     for (auto v : vertexSet) {
         v->dist = INF;
         v->path = nullptr;
+        v->pathEdge = -1;
     }
     auto s = findVertex(orig);
     s->dist = 0;
@@ -267,36 +479,47 @@ void Graph<T>::unweightedShortestPath(const T &orig) {
     while (!q.empty()) {
         auto v = q.front();
         q.pop();
-        for (auto e : v->adj)
+        for (unsigned j = 0; j < v->getNumEdges(); j++) {
+            Edge<T> e = v->getEdge(j);
             if (v->dist + 1 < e.dest->dist) {
                 e.dest->dist = v->dist + 1;
                 e.dest->path = v;
+                e.dest->pathEdge = j;
                 q.push(e.dest);
             }
+        }
     }
 }
 
 
 
 template<class T>
-void Graph<T>::dijkstraShortestPath(const T &origin) {
+void Graph<T>::dijkstraShortestPath(const T &origin, CancelToken *cancel) {
     MutablePriorityQueue<Vertex<T> > q;
+    unsigned settled = 0;
     for (auto v : vertexSet) {
         v->dist = INF;
+        v->estimate = 0;
         v->path = nullptr;
+        v->pathEdge = -1;
     }
     auto s = findVertex(origin);
     s->dist = 0;
 
     q.insert(s);
     while(!q.empty()){
+        if (shouldStop(cancel, settled))
+            break;
         auto v = q.extractMin();
-        for(auto e : v->adj){
+        for (unsigned j = 0; j < v->getNumEdges(); j++) {
+            Edge<T> e = v->getEdge(j);
             auto oldDist = e.dest->dist;
             if (v->dist + e.weight < e.dest->dist) {
                 e.dest->dist = v->dist + e.weight;
                 e.dest->path = v;
+                e.dest->pathEdge = j;
                 if(oldDist == INF) q.insert(e.dest);
+                else q.decreaseKey(e.dest);
             }
         }
     }
@@ -306,28 +529,36 @@ void Graph<T>::dijkstraShortestPath(const T &origin) {
 
 
 template<class T>
-void Graph<T>::bellmanFordShortestPath(const T &orig) {
+void Graph<T>::bellmanFordShortestPath(const T &orig, CancelToken *cancel) {
     for (auto v : vertexSet) {
         v->dist = INF;
         v->path = nullptr;
+        v->pathEdge = -1;
     }
     auto s = findVertex(orig);
     s->dist = 0;
     for (unsigned i = 1; i < vertexSet.size(); i++) {
+        // every round goes over all the edges, so the clock is looked at once per round
+        if (cancel != nullptr && cancel->poll())
+            return;
         for (auto v: vertexSet) {
-            for (auto e: v->adj) {
+            for (unsigned j = 0; j < v->getNumEdges(); j++) {
+                Edge<T> e = v->getEdge(j);
                 if (v->dist + e.weight < e.dest->dist) {
                     e.dest->dist = v->dist + e.weight;
                     e.dest->path = v;
+                    e.dest->pathEdge = j;
                 }
             }
         }
     }
     for (auto v: vertexSet) {
-        for (auto e: v->adj) {
+        for (unsigned j = 0; j < v->getNumEdges(); j++) {
+            Edge<T> e = v->getEdge(j);
             if (v->dist + e.weight < e.dest->dist) {
                 e.dest->dist = v->dist + e.weight;
                 e.dest->path = v;
+                e.dest->pathEdge = j;
                 //cout << "Negative cycle!" << endl;
             }
         }
@@ -336,6 +567,371 @@ void Graph<T>::bellmanFordShortestPath(const T &orig) {
 
 
 
+/*
+ * Time-dependent Dijkstra: after the call, dist holds the earliest arrival time (in seconds)
+ * at each vertex when leaving orig at the given departure time.
+ * Edges without a profile are travelled at free flow speed.
+ */
+template<class T>
+void Graph<T>::timeDependentShortestPath(const T &orig, double departure, const TimeProfiles &profiles, CancelToken *cancel) {
+    MutablePriorityQueue<Vertex<T> > q;
+    unsigned settled = 0;
+    for (auto v : vertexSet) {
+        v->dist = INF;
+        v->estimate = 0;
+        v->path = nullptr;
+        v->pathEdge = -1;
+    }
+    auto s = findVertex(orig);
+    s->dist = departure;
+
+    q.insert(s);
+    while(!q.empty()){
+        if (shouldStop(cancel, settled))
+            break;
+        auto v = q.extractMin();
+        for (unsigned j = 0; j < v->getNumEdges(); j++) {
+            Edge<T> e = v->getEdge(j);
+            double arrival = v->dist + profiles.travelTime(e.profile, e.weight, v->dist);
+            if (arrival < e.dest->dist) {
+                auto oldDist = e.dest->dist;
+                e.dest->dist = arrival;
+                e.dest->path = v;
+                e.dest->pathEdge = j;
+                if(oldDist == INF) q.insert(e.dest);
+                else q.decreaseKey(e.dest);
+            }
+        }
+    }
+}
+
+/*
+ * Time-dependent A* from orig to dest, stopping as soon as dest is settled.
+ * The lower bound is the straight line distance travelled at the fastest factor of any profile,
+ * which is admissible because edge weights are never shorter than the straight line.
+ * Requires T to provide getXCoord() and getYCoord().
+ */
+template<class T>
+void Graph<T>::timeDependentAStar(const T &orig, const T &dest, double departure, const TimeProfiles &profiles, CancelToken *cancel) {
+    MutablePriorityQueue<Vertex<T> > q;
+    unsigned settled = 0;
+    auto t = findVertex(dest);
+    auto s = findVertex(orig);
+    if (s == nullptr || t == nullptr)
+        return;
+    double bestSpeed = profiles.getSpeed() / profiles.getMinFactor();
+    for (auto v : vertexSet) {
+        v->dist = INF;
+        v->path = nullptr;
+        v->pathEdge = -1;
+        v->visited = false;
+        v->estimate = hypot(v->info.getXCoord() - t->info.getXCoord(), v->info.getYCoord() - t->info.getYCoord()) / bestSpeed;
+    }
+    s->dist = departure;
+
+    q.insert(s);
+    while(!q.empty()){
+        if (shouldStop(cancel, settled))
+            break;
+        auto v = q.extractMin();
+        v->visited = true;
+        if (v == t)
+            break;
+        for (unsigned j = 0; j < v->getNumEdges(); j++) {
+            Edge<T> e = v->getEdge(j);
+            if (e.dest->visited)
+                continue;
+            double arrival = v->dist + profiles.travelTime(e.profile, e.weight, v->dist);
+            if (arrival < e.dest->dist) {
+                auto oldDist = e.dest->dist;
+                e.dest->dist = arrival;
+                e.dest->path = v;
+                e.dest->pathEdge = j;
+                if(oldDist == INF) q.insert(e.dest);
+                else q.decreaseKey(e.dest);
+            }
+        }
+    }
+    for (auto v : vertexSet) {
+        v->estimate = 0;
+        v->visited = false;
+    }
+}
+
+/*
+ * Dijkstra from orig to dest that only expands vertices inside the ellipse with foci orig and dest
+ * whose straight line distances to both add up to at most maxLength, stopping as soon as dest is settled.
+ * Edge weights are never shorter than the straight line, so any path through a vertex outside the
+ * ellipse costs more than maxLength: when dest is reached with a distance up to maxLength the path
+ * found is a shortest path of the whole graph. Otherwise (or if interrupted by cancel) the result says
+ * nothing and the caller must fall back to an unrestricted search.
+ * Requires T to provide getXCoord() and getYCoord().
+ */
+template<class T>
+bool Graph<T>::corridorShortestPath(const T &orig, const T &dest, double maxLength, CancelToken *cancel) {
+    MutablePriorityQueue<Vertex<T> > q;
+    unsigned settled = 0;
+    auto t = findVertex(dest);
+    auto s = findVertex(orig);
+    if (s == nullptr || t == nullptr)
+        return false;
+    for (auto v : vertexSet) {
+        v->dist = INF;
+        v->estimate = 0;
+        v->path = nullptr;
+        v->pathEdge = -1;
+    }
+    s->dist = 0;
+
+    q.insert(s);
+    while(!q.empty()){
+        if (shouldStop(cancel, settled))
+            return false;
+        auto v = q.extractMin();
+        if (v == t)
+            break;
+        for (unsigned j = 0; j < v->getNumEdges(); j++) {
+            Edge<T> e = v->getEdge(j);
+            if (v->dist + e.weight >= e.dest->dist)
+                continue;
+            if (e.dest->dist == INF) {
+                // first time the vertex is reached, check it against the ellipse
+                const T &w = e.dest->info;
+                if (hypot(w.getXCoord() - s->info.getXCoord(), w.getYCoord() - s->info.getYCoord()) +
+                    hypot(w.getXCoord() - t->info.getXCoord(), w.getYCoord() - t->info.getYCoord()) > maxLength)
+                    continue;
+            }
+            auto oldDist = e.dest->dist;
+            e.dest->dist = v->dist + e.weight;
+            e.dest->path = v;
+            e.dest->pathEdge = j;
+            if(oldDist == INF) q.insert(e.dest);
+            else q.decreaseKey(e.dest);
+        }
+    }
+    return t->dist <= maxLength;
+}
+
+/*
+ * Dijkstra from several sources at once: every vertex ends up with the distance (and path) from its
+ * nearest source. Returns, for each vertex position in vertexSet, the index in sources of that nearest
+ * source (-1 if no source reaches it), which is the network Voronoi partition of the graph.
+ */
+template<class T>
+vector<int> Graph<T>::multiSourceShortestPath(const vector<T> &sources) {
+    MutablePriorityQueue<Vertex<T> > q;
+    vector<int> owner(vertexSet.size(), -1);
+    for (auto v : vertexSet) {
+        v->dist = INF;
+        v->estimate = 0;
+        v->path = nullptr;
+        v->pathEdge = -1;
+    }
+    for (unsigned i = 0; i < sources.size(); i++) {
+        auto s = findVertex(sources[i]);
+        if (s == nullptr || s->dist == 0)
+            continue;
+        s->dist = 0;
+        owner[s->posAtVec] = i;
+        q.insert(s);
+    }
+
+    while(!q.empty()){
+        auto v = q.extractMin();
+        for (unsigned j = 0; j < v->getNumEdges(); j++) {
+            Edge<T> e = v->getEdge(j);
+            if (v->dist + e.weight < e.dest->dist) {
+                auto oldDist = e.dest->dist;
+                e.dest->dist = v->dist + e.weight;
+                e.dest->path = v;
+                e.dest->pathEdge = j;
+                owner[e.dest->posAtVec] = owner[v->posAtVec];
+                if(oldDist == INF) q.insert(e.dest);
+                else q.decreaseKey(e.dest);
+            }
+        }
+    }
+    return owner;
+}
+
+/*
+ * One to all Dijkstra that stops as soon as the next vertex is further than radius from orig.
+ * Returns the vertices within the radius by increasing distance; their dist and path are valid.
+ * Without profiles the radius is a distance, with profiles it is a travel time in seconds when
+ * leaving orig at the given departure time.
+ */
+template<class T>
+vector<Vertex<T> *> Graph<T>::boundedShortestPath(const T &orig, double radius, const TimeProfiles *profiles, double departure) {
+    MutablePriorityQueue<Vertex<T> > q;
+    vector<Vertex<T> *> res;
+    for (auto v : vertexSet) {
+        v->dist = INF;
+        v->estimate = 0;
+        v->path = nullptr;
+        v->pathEdge = -1;
+    }
+    auto s = findVertex(orig);
+    if (s == nullptr)
+        return res;
+    s->dist = 0;
+
+    q.insert(s);
+    while(!q.empty()){
+        auto v = q.extractMin();
+        if (v->dist > radius)
+            break;
+        res.push_back(v);
+        for (unsigned j = 0; j < v->getNumEdges(); j++) {
+            Edge<T> e = v->getEdge(j);
+            double cost = profiles == nullptr ? e.weight : profiles->travelTime(e.profile, e.weight, departure + v->dist);
+            if (v->dist + cost < e.dest->dist) {
+                auto oldDist = e.dest->dist;
+                e.dest->dist = v->dist + cost;
+                e.dest->path = v;
+                e.dest->pathEdge = j;
+                if(oldDist == INF) q.insert(e.dest);
+                else q.decreaseKey(e.dest);
+            }
+        }
+    }
+    return res;
+}
+
+/*
+ * Alternative routes from orig to dest by the penalty method: each accepted route has the weights of
+ * its edges (in both directions) increased and the search is repeated, so the next route is pushed away
+ * from the ones already found. A route is only accepted if its real cost is at most maxStretch times the
+ * shortest one and if at most maxOverlap of its length is shared with the routes already accepted.
+ * A reverse shortest path tree to dest is computed once and reused by every search: penalties only
+ * increase weights, so its distances stay a consistent A* bound, and the first route is read from it directly.
+ */
+template<class T>
+vector<vector<T> > Graph<T>::alternativeRoutes(const T &orig, const T &dest, unsigned k, double maxStretch, double maxOverlap) {
+    typedef pair<double, unsigned> QueueEntry;
+    const double penalty = 0.4;
+    vector<vector<T> > res;
+    auto s = findVertex(orig);
+    auto t = findVertex(dest);
+    if (s == nullptr || t == nullptr || k == 0)
+        return res;
+    unsigned n = vertexSet.size();
+    unsigned source = s->posAtVec, target = t->posAtVec;
+
+    //------------------EDGE INDEXES AND REVERSE TREE TO DEST------------------
+    vector<unsigned> firstEdge(n + 1, 0);
+    for (unsigned v = 0; v < n; v++)
+        firstEdge[v + 1] = firstEdge[v] + vertexSet[v]->getNumEdges();
+    vector<vector<pair<unsigned, double> > > rev(n);
+    for (auto v : vertexSet)
+        for (auto & e : v->getAdj())
+            rev[e.dest->posAtVec].push_back(make_pair(v->posAtVec, e.weight));
+
+    vector<double> h(n, INF);
+    vector<int> next(n, -1);
+    priority_queue<QueueEntry, vector<QueueEntry>, greater<QueueEntry> > q;
+    h[target] = 0;
+    q.push(QueueEntry(0, target));
+    while (!q.empty()) {
+        auto top = q.top();
+        q.pop();
+        if (top.first > h[top.second]) continue;
+        for (auto & e : rev[top.second])
+            if (top.first + e.second < h[e.first]) {
+                h[e.first] = top.first + e.second;
+                next[e.first] = top.second;
+                q.push(QueueEntry(h[e.first], e.first));
+            }
+    }
+    if (h[source] == INF)
+        return res;
+
+    vector<unsigned> path;
+    for (int v = source; v != -1; v = next[v])
+        path.push_back(v);
+
+    //------------------PENALTY ITERATIONS------------------
+    double best = h[source];
+    vector<float> factor(firstEdge[n], 1);      // weight multiplier of each edge
+    vector<bool> accepted(firstEdge[n], false); // edges used by accepted routes
+    vector<double> g(n, INF);
+    vector<int> par(n, -1);
+    vector<unsigned> touched;
+    unsigned maxIterations = 4 * k;
+
+    for (unsigned it = 0; it < maxIterations && res.size() < k; it++) {
+        if (it > 0) {
+            // A* over the penalised weights, reusing the search state of the previous iteration
+            for (auto v : touched) {
+                g[v] = INF;
+                par[v] = -1;
+            }
+            touched.clear();
+            g[source] = 0;
+            touched.push_back(source);
+            q.push(QueueEntry(h[source], source));
+            while (!q.empty()) {
+                auto top = q.top();
+                q.pop();
+                unsigned v = top.second;
+                if (top.first > g[v] + h[v]) continue;
+                if (v == target) break;
+                for (unsigned i = 0; i < vertexSet[v]->getNumEdges(); i++) {
+                    Edge<T> e = vertexSet[v]->getEdge(i);
+                    unsigned w = e.dest->posAtVec;
+                    double cost = g[v] + e.weight * factor[firstEdge[v] + i];
+                    if (h[w] != INF && cost < g[w]) {
+                        if (g[w] == INF) touched.push_back(w);
+                        g[w] = cost;
+                        par[w] = v;
+                        q.push(QueueEntry(g[w] + h[w], w));
+                    }
+                }
+            }
+            q = priority_queue<QueueEntry, vector<QueueEntry>, greater<QueueEntry> >();
+            path.clear();
+            for (int v = target; v != -1; v = par[v])
+                path.push_back(v);
+            reverse(path.begin(), path.end());
+        }
+
+        // real cost and overlap with the accepted routes
+        double cost = 0, shared = 0;
+        vector<unsigned> edges;
+        for (unsigned i = 0; i + 1 < path.size(); i++) {
+            unsigned e = firstEdge[path[i]];
+            double w = INF;
+            for (unsigned j = 0; j < vertexSet[path[i]]->getNumEdges(); j++) {
+                Edge<T> edge = vertexSet[path[i]]->getEdge(j);
+                if (edge.dest->posAtVec == path[i + 1] && edge.weight < w) {
+                    w = edge.weight;
+                    e = firstEdge[path[i]] + j;
+                }
+            }
+            cost += w;
+            if (accepted[e]) shared += w;
+            edges.push_back(e);
+        }
+        if (res.empty() || (cost <= maxStretch * best && shared <= maxOverlap * cost)) {
+            vector<T> route;
+            for (auto v : path)
+                route.push_back(vertexSet[v]->info);
+            res.push_back(route);
+            for (auto e : edges)
+                accepted[e] = true;
+        }
+
+        // penalise the route just found and the opposite direction of its roads
+        for (unsigned i = 0; i < edges.size(); i++) {
+            factor[edges[i]] += penalty;
+            unsigned u = path[i + 1];
+            for (unsigned j = 0; j < vertexSet[u]->getNumEdges(); j++)
+                if (vertexSet[u]->getEdge(j).dest->posAtVec == path[i])
+                    factor[firstEdge[u] + j] += penalty;
+        }
+    }
+    return res;
+}
+
 
     template<class T>
 vector<T> Graph<T>::getPathTo(const T &origin, const T &dest) const{
@@ -364,6 +960,29 @@ vector<T> Graph<T>::getPath(const T &origin, const T &dest) const {
 
 
 
+/*
+ * Appends to path the positions in vertexSet of the vertices from the origin of the last search to dest,
+ * following the parent edges, so it takes time proportional to the length of the path. The origin is not
+ * repeated if it is already the last element of path, so consecutive legs can be chained.
+ * Returns the length of the appended path (sum of edge weights), or INF if dest was not reached.
+ */
+template<class T>
+double Graph<T>::appendPath(const Vertex<T> *dest, vector<uint32_t> &path) const {
+    if (dest == nullptr || dest->dist == INF)
+        return INF;
+    size_t start = path.size();
+    double length = 0;
+    for (auto v = dest; v != nullptr; v = v->path) {
+        path.push_back(v->posAtVec);
+        if (v->path != nullptr)
+            length += v->path->getEdge(v->pathEdge).weight;
+    }
+    reverse(path.begin() + start, path.end());
+    if (start > 0 && path[start - 1] == path[start])
+        path.erase(path.begin() + start);
+    return length;
+}
+
 template <class T>
 int Graph<T>::findVertexIdx(const T &in) const {
     for (unsigned i = 0; i < vertexSet.size(); i++)
@@ -402,7 +1021,7 @@ void Graph<T>::floydWarshallShortestPath() {
             W[i][j] = i == j? 0 : INF;
             P[i][j] = -1;
         }
-        for (auto e : vertexSet[i]->adj) {
+        for (auto e : vertexSet[i]->getAdj()) {
             int j = findVertexIdx(e.dest->info);
             W[i][j] = e.weight;
             P[i][j] = i;
@@ -7,7 +7,13 @@
 #include <cmath>
 #include <iostream>
 #include <algorithm>
+#include <map>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <sys/stat.h>
 #include "GraphFuncs.h"
+#include "ServiceScheduler.h"
 
 
 using namespace std;
@@ -111,32 +117,380 @@ Graph<Node> loadGraph( string city){
 
 
 
-        if(!graph.addEdge(Node(id1), Node(id2), distance, true)){
-            cout<<"Failed to add an edge from node "<<id1<<" to "<<id2<<" !!!";
-            return graph;
-        }
-        total++;
-        if(!graph.addEdge(Node(id2), Node(id1), distance, false)){
-            cout<<"Failed to add an edge from node "<<id2<<" to "<<id1<<" !!!";
+        if(!graph.addRoad(Node(id1), Node(id2), distance)){
+            cout<<"Failed to add a road between node "<<id1<<" and "<<id2<<" !!!";
             return graph;
         }
         total++;
     }
 
-    if(total != (aux * 2)) {    //edge num check
+    if(total != aux) {    //edge num check
+        cout << "Read wrong number of edges! ";
+        return graph;
+    }
+
+    return graph;
+}
+
+/*
+ * Reads a whole file into text. Returns false if it can't be opened.
+ */
+static bool readWholeFile(const string &path, string &text) {
+    ifstream file(path, ios::binary);
+    if (!file)
+        return false;
+    file.seekg(0, ios::end);
+    text.resize(file.tellg());
+    file.seekg(0, ios::beg);
+    file.read(&text[0], text.size());
+    return true;
+}
+
+/*
+ * Splits text[begin, text.size()) into `parts` chunks that start at the beginning of a line.
+ * Returns the start of each chunk followed by text.size().
+ */
+static vector<size_t> lineChunks(const string &text, size_t begin, unsigned parts) {
+    vector<size_t> start(1, begin);
+    for (unsigned c = 1; c < parts; c++) {
+        size_t pos = max(start.back(), begin + (text.size() - begin) * c / parts);
+        pos = text.find('\n', pos);
+        if (pos == string::npos)
+            break;
+        start.push_back(pos + 1);
+    }
+    start.push_back(text.size());
+    return start;
+}
+
+/*
+ * Reads the next number of a "(a, b, c)" line starting at p, without going past the end of the line.
+ */
+static bool nextNumber(const char *&p, const char *end, double &value) {
+    while (p < end && *p != '\n' && !isdigit(*p) && *p != '-' && *p != '+' && *p != '.')
+        p++;
+    if (p >= end || *p == '\n')
+        return false;
+    char *after;
+    value = strtod(p, &after);
+    if (after == p)
+        return false;
+    p = after;
+    return true;
+}
+
+/*
+ * Parses the lines of the chunks in parallel, one chunk per thread. parseLine reads one line into a record
+ * (a copy of blank) and returns false for lines that are not records; records go to the thread's own buffer. The buffers are then copied, in
+ * file order, to the positions given by a prefix sum of their sizes.
+ */
+template <class R>
+static vector<R> parseChunks(const string &text, const vector<size_t> &chunks, const R &blank,
+                             const function<bool(const char *&, const char *, R &)> &parseLine) {
+    unsigned parts = chunks.size() - 1;
+    vector<vector<R>> buffers(parts);
+    vector<thread> workers;
+    for (unsigned c = 0; c < parts; c++)
+        workers.push_back(thread([&, c]() {
+            const char *p = text.data() + chunks[c], *end = text.data() + chunks[c + 1];
+            R record = blank;
+            while (p < end) {
+                if (parseLine(p, end, record))
+                    buffers[c].push_back(record);
+                while (p < end && *p++ != '\n');
+            }
+        }));
+    for (auto & w : workers)
+        w.join();
+
+    vector<size_t> offset(parts + 1, 0);
+    for (unsigned c = 0; c < parts; c++)
+        offset[c + 1] = offset[c] + buffers[c].size();
+    vector<R> records(offset[parts], blank);
+    workers.clear();
+    for (unsigned c = 0; c < parts; c++)
+        workers.push_back(thread([&, c]() {
+            copy(buffers[c].begin(), buffers[c].end(), records.begin() + offset[c]);
+        }));
+    for (auto & w : workers)
+        w.join();
+    return records;
+}
+
+/*
+ * Parses a nodes or edges file already in memory: the first line has the number of records.
+ */
+template <class R>
+static vector<R> parseMapFile(const string &text, unsigned threads, int &declared, const R &blank,
+                              const function<bool(const char *&, const char *, R &)> &parseLine) {
+    declared = atoi(text.c_str());
+    size_t begin = text.find('\n');
+    begin = begin == string::npos ? text.size() : begin + 1;
+    return parseChunks<R>(text, lineChunks(text, begin, threads), blank, parseLine);
+}
+
+Graph<Node> loadGraphParallel(string city, unsigned threads){
+    Graph<Node> graph;
+    if (threads == 0)
+        threads = max(1u, thread::hardware_concurrency());
+    string nodesText, edgesText;
+    if (!readWholeFile("../mapas/" + city + "/nodes_x_y_" + city + ".txt", nodesText)) {
+        cout << "Couldn't open coordinates file!" << endl;
+        return graph;
+    }
+    if (!readWholeFile("../mapas/" + city + "/edges_" + city + ".txt", edgesText)) {
+        cout << "Couldn't open edge file!" << endl;
+        return graph;
+    }
+
+    //-------------------------------PARSE BOTH FILES AT ONCE----------------------
+    int numNodes, numEdges;
+    vector<Node> nodes;
+    vector<pair<int, int>> edges;
+    thread edgeParser([&]() {
+        edges = parseMapFile<pair<int, int>>(edgesText, threads, numEdges, make_pair(0, 0), [](const char *&p, const char *end, pair<int, int> &edge) {
+            double id1, id2;
+            if (!nextNumber(p, end, id1) || !nextNumber(p, end, id2))
+                return false;
+            edge = make_pair((int) id1, (int) id2);
+            return true;
+        });
+    });
+    nodes = parseMapFile<Node>(nodesText, threads, numNodes, Node(0), [](const char *&p, const char *end, Node &node) {
+        double id, x, y;
+        if (!nextNumber(p, end, id) || !nextNumber(p, end, x) || !nextNumber(p, end, y))
+            return false;
+        node = Node((int) id, x, y);
+        return true;
+    });
+    edgeParser.join();
+
+    //-------------------------------VERTEX----------------------
+    sort(nodes.begin(), nodes.end(), [](const Node &a, const Node &b) { return a.getId() < b.getId(); });
+    nodes.erase(unique(nodes.begin(), nodes.end(), [](const Node &a, const Node &b) { return a.getId() == b.getId(); }), nodes.end());
+    for (auto & n : nodes)
+        graph.addNewVertex(n);
+    if (graph.getVertexSet().size() != numNodes) {    //vertex num check
+        cout << "Read wrong number of vertex! ";
+        return graph;
+    }
+
+    //------------------------EDGES-----------------------------
+    if (edges.size() != numEdges) {    //edge num check
         cout << "Read wrong number of edges! ";
         return graph;
     }
+    vector<pair<uint32_t, uint32_t>> ends(edges.size());
+    vector<double> weights(edges.size());
+    vector<char> found(threads, true);     // not vector<bool>: each thread writes its own flag
+    vector<thread> workers;
+    for (unsigned t = 0; t < threads; t++)
+        workers.push_back(thread([&, t]() {
+            auto byId = [](const Node &a, int id) { return a.getId() < id; };
+            for (size_t i = edges.size() * t / threads; i < edges.size() * (t + 1) / threads; i++) {
+                auto n1 = lower_bound(nodes.begin(), nodes.end(), edges[i].first, byId);
+                auto n2 = lower_bound(nodes.begin(), nodes.end(), edges[i].second, byId);
+                if (n1 == nodes.end() || n1->getId() != edges[i].first || n2 == nodes.end() || n2->getId() != edges[i].second) {
+                    found[t] = false;
+                    return;
+                }
+                ends[i] = make_pair(n1 - nodes.begin(), n2 - nodes.begin());
+                weights[i] = getEdgeWeight(n1->getXCoord(), n1->getYCoord(), n2->getXCoord(), n2->getYCoord());
+            }
+        }));
+    for (auto & w : workers)
+        w.join();
+    if (find(found.begin(), found.end(), false) != found.end()) {
+        cout << "Failed to find the vertices of some edge!!!";
+        return graph;
+    }
+    graph.addRoads(ends, weights, threads);
+    return graph;
+}
+
+uint64_t mapSourceStamp(string city){
+    string files[] = {"../mapas/" + city + "/nodes_x_y_" + city + ".txt", "../mapas/" + city + "/edges_" + city + ".txt"};
+    // FNV-1a over the size and modification time of each file
+    uint64_t h = 14695981039346656037ULL;
+    for (auto &file : files) {
+        struct stat info;
+        if (stat(file.c_str(), &info) != 0)
+            return 0;
+        uint64_t fields[] = {(uint64_t) info.st_size, (uint64_t) info.st_mtime};
+        for (uint64_t field : fields)
+            for (unsigned b = 0; b < sizeof(field); b++) {
+                h ^= (field >> (8 * b)) & 0xff;
+                h *= 1099511628211ULL;
+            }
+    }
+    return h;
+}
 
+bool openCityImage(GraphImage &image, string city){
+    string path = "../mapas/" + city + "/image_" + city + ".bin";
+    uint64_t source = mapSourceStamp(city);
+    // an image built from older map files is rebuilt; without the map files, the image is all there is
+    if (image.attach(path) && (source == 0 || image.getSource() == source))
+        return true;
+    image.detach();
+    Graph<Node> graph = loadGraphParallel(city);
+    // readFromCityFile drops the roads of length 0 after loading, so the image leaves them out to stay equal to
+    // the graph that is routed (see imageMatchesGraph)
+    for (auto v : graph.getVertexSet())
+        for (int i = 0; i < (int) v->getNumEdges(); i++)
+            if (v->getEdge(i).getWeight() <= 0)
+                v->removeEdge(i--);
+    if (graph.getNumVertex() == 0 || !GraphImage::build(graph, path, source))
+        return false;
+    return image.attach(path);
+}
+
+Graph<Node> loadGraphImage(const GraphImage &image, unsigned threads){
+    Graph<Node> graph;
+    if (!image.isAttached())
+        return graph;
+    for (unsigned v = 0; v < image.getNumVertex(); v++)
+        graph.addNewVertex(image.getNode(v));
+    vector<pair<uint32_t, uint32_t>> ends;
+    vector<double> weights;
+    ends.reserve(image.getNumEdges());
+    weights.reserve(image.getNumEdges());
+    // every road is in the image once from each of its ends; it is added from the one with the lower index
+    // (a loop is twice at the same vertex)
+    for (unsigned v = 0; v < image.getNumVertex(); v++) {
+        bool loop = false;
+        for (unsigned e = image.edgeBegin(v); e < image.edgeEnd(v); e++) {
+            unsigned w = image.getTarget(e);
+            if (w < v || (w == v && (loop = !loop) == false))
+                continue;
+            ends.emplace_back(v, w);
+            weights.push_back(image.getWeight(e));
+        }
+    }
+    graph.addRoads(ends, weights, threads);
     return graph;
 }
 
+bool imageMatchesGraph(const GraphImage &image, const Graph<Node> &graph){
+    if (!image.isAttached() || image.getNumVertex() != (unsigned) graph.getNumVertex())
+        return false;
+    vector<Vertex<Node> *> vertexSet = graph.getVertexSet();
+    for (unsigned v = 0; v < vertexSet.size(); v++)
+        if (image.getNode(v).getId() != vertexSet[v]->getInfo().getId() ||
+            image.edgeEnd(v) - image.edgeBegin(v) != vertexSet[v]->getNumEdges())
+            return false;
+    return true;
+}
+
 double getEdgeWeight(double x1, double y1, double x2, double y2) {
 
     return sqrt(pow(x2 - x1,2)  + pow(y2 - y1,2) );
 }
 
-vector<Vertex<Node>*> readFromCityFile(Graph<Node> &graph,string city){
+TimeProfiles loadTimeProfiles(Graph<Node> &graph, string city){
+    ifstream profileFile;
+    string line;
+    line="../files/"+city+"/"+city+"_profiles.txt";
+    profileFile.open(line);
+    if(!profileFile){
+        return deriveTimeProfiles(graph);
+    }
+
+    double speed;
+    profileFile >> speed;
+    getline(profileFile, line);     //clear /n
+
+    //------------------------READ BREAKPOINTS-----------------------
+    vector<double> breakpoints;
+    double aux;
+    getline(profileFile, line);
+    line.erase(remove(line.begin(), line.end(), '('), line.end());
+    line.erase(remove(line.begin(), line.end(), ')'), line.end());
+    line.erase(remove(line.begin(), line.end(), ','), line.end());
+    stringstream breakStream(line);
+    while(breakStream >> aux)
+        breakpoints.push_back(aux * 3600);
+
+    TimeProfiles profiles(breakpoints, speed / 3.6);
+
+    //------------------------READ ROAD PROFILES-----------------------
+    while(getline(profileFile, line)){
+        line.erase(remove(line.begin(), line.end(), '('), line.end());
+        line.erase(remove(line.begin(), line.end(), ')'), line.end());
+        line.erase(remove(line.begin(), line.end(), ','), line.end());
+
+        int id1, id2;
+        float factor;
+        vector<float> factors;
+        stringstream lineS(line);
+        if(!(lineS >> id1 >> id2)) continue;
+        while(lineS >> factor)
+            factors.push_back(factor);
+
+        int profile = profiles.addProfile(factors);
+        Vertex<Node>* v1 = vertexBinarySearch(graph.getVertexSet(),Node(id1),0,graph.getVertexSet().size() - 1);
+        Vertex<Node>* v2 = vertexBinarySearch(graph.getVertexSet(),Node(id2),0,graph.getVertexSet().size() - 1);
+        if(profile < 0 || v1 == nullptr || v2 == nullptr){
+            cout<<"Ignoring invalid profile for road ("<<id1<<", "<<id2<<")\n";
+            continue;
+        }
+
+        //both directions of the road share the profile
+        for(int i=0;i<v1->getAdj().size();i++)
+            if(v1->getAdj().at(i).getDest()==v2) v1->setEdgeProfile(i, profile);
+        for(int i=0;i<v2->getAdj().size();i++)
+            if(v2->getAdj().at(i).getDest()==v1) v2->setEdgeProfile(i, profile);
+    }
+    return profiles;
+}
+
+TimeProfiles deriveTimeProfiles(Graph<Node> &graph){
+    // hours of the day where the congestion shape changes, morning peak at 8h30 and evening peak at 18h
+    vector<double> hours = {0, 6, 7.5, 8.5, 10, 12.5, 14, 16.5, 18, 19.5, 21};
+    vector<float> shape = {0, 0.1, 0.8, 1, 0.3, 0.4, 0.3, 0.6, 1, 0.5, 0.1};
+    vector<float> ringIntensity = {1, 0.7, 0.4, 0.15};   // from the centre outwards
+    const float peakDelay = 1.2;    // a fully congested road takes 2.2x the free flow time at peak
+    const double speed = 40 / 3.6;  // urban free flow speed (m/s)
+
+    vector<double> breakpoints;
+    for(auto h : hours) breakpoints.push_back(h * 3600);
+    TimeProfiles profiles(breakpoints, speed);
+
+    vector<int> ringProfile;
+    for(auto intensity : ringIntensity){
+        vector<float> factors;
+        for(auto s : shape) factors.push_back(1 + peakDelay * intensity * s);
+        ringProfile.push_back(profiles.addProfile(factors));
+    }
+
+    //------------------------MAP CENTRE AND RADIUS-----------------------
+    double xCentre = 0, yCentre = 0, radius = 0;
+    if(graph.getVertexSet().empty()) return profiles;
+    for(auto v : graph.getVertexSet()){
+        xCentre += v->getInfo().getXCoord();
+        yCentre += v->getInfo().getYCoord();
+    }
+    xCentre /= graph.getVertexSet().size();
+    yCentre /= graph.getVertexSet().size();
+    for(auto v : graph.getVertexSet())
+        radius = max(radius, getEdgeWeight(xCentre, yCentre, v->getInfo().getXCoord(), v->getInfo().getYCoord()));
+    if(radius <= 0) return profiles;
+
+    //------------------------ASSIGN ONE RING PER ROAD-----------------------
+    for(auto v : graph.getVertexSet()){
+        vector<Edge<Node>> adj = v->getAdj();
+        for(int i = 0; i < adj.size(); i++){
+            double xMid = (v->getInfo().getXCoord() + adj[i].getDest()->getInfo().getXCoord()) / 2;
+            double yMid = (v->getInfo().getYCoord() + adj[i].getDest()->getInfo().getYCoord()) / 2;
+            int ring = (int) (getEdgeWeight(xCentre, yCentre, xMid, yMid) / radius * ringProfile.size());
+            ring = min(ring, (int) ringProfile.size() - 1);
+            v->setEdgeProfile(i, ringProfile[ring]);
+        }
+    }
+    return profiles;
+}
+
+vector<Vertex<Node>*> readFromCityFile(Graph<Node> &graph,string city, bool partial){
     ifstream cityFile;
     string aux;
     vector<Vertex<Node>*> outIfFail;
@@ -147,10 +501,25 @@ vector<Vertex<Node>*> readFromCityFile(Graph<Node> &graph,string city){
         return outIfFail;
     }
     getline(cityFile,aux);
-    Vertex<Node>* garage=vertexBinarySearch(graph.getVertexSet(),Node(stoi(aux)),0,graph.getVertexSet().size());
-    Node newInfo = garage->getInfo();
-    newInfo.setType(Type::GARAGEM);
-    garage->setInfo(newInfo);
+    vector<Vertex<Node>*> garages;
+    int idGarage;
+    aux.erase(remove(aux.begin(), aux.end(), ','), aux.end());  //removes ','
+    stringstream garageStream(aux);
+    while(garageStream >> idGarage){
+        Vertex<Node>* garage=vertexBinarySearch(graph.getVertexSet(),Node(idGarage),0,graph.getVertexSet().size() - 1);
+        if(garage== nullptr){
+            cout<<"Failed to find garage "<<idGarage<<" !!!";
+            return outIfFail;
+        }
+        Node newInfo = garage->getInfo();
+        newInfo.setType(Type::GARAGEM);
+        garage->setInfo(newInfo);
+        garages.push_back(garage);
+    }
+    if(garages.empty()){
+        cout<<"The city file has no garage! ";
+        return outIfFail;
+    }
 
     getline(cityFile,aux);  // clear separator
 
@@ -170,30 +539,18 @@ vector<Vertex<Node>*> readFromCityFile(Graph<Node> &graph,string city){
         Vertex<Node>* v2 = vertexBinarySearch(graph.getVertexSet(),Node(id2),0,graph.getVertexSet().size()); //search dest vertex
 
         if(v1== nullptr|| v2== nullptr){
+            if(partial) continue;   // the road is in a region not loaded yet
             cout<<"Failed to find vertex "<<id1<<" or vertex "<<id2<<" while making CFC!!!";
             return outIfFail;
         }
-        //remove edge from 1 vertex
-        for(int i=0;i<v1->getAdj().size();i++){
-            if(v1->getAdj().at(i).getDest()==v2){
-                v1->removeEdge(i);
-                break;
-            }
-        }
-
-        //remove edge from the other vertex
-        for(int i=0;i<v2->getAdj().size();i++){
-            if(v2->getAdj().at(i).getDest()==v1){
-                v2->removeEdge(i);
-                break;
-            }
-        }
+        //remove the road in both directions
+        graph.removeRoad(v1, v2);
 
     }
-    return cleanEdgesNVertex(graph,garage);
+    return cleanEdgesNVertex(graph,garages);
 }
 
-vector<Vertex<Node>*> cleanEdgesNVertex(Graph<Node> graph, Vertex<Node>* garage){
+vector<Vertex<Node>*> cleanEdgesNVertex(Graph<Node> graph, vector<Vertex<Node>*> garages){
     vector<Vertex<Node>*> visitedVertex;
     //---------------------CLEAN USELESS EDGES---------------------
     for(auto v : graph.getVertexSet()) {
@@ -206,7 +563,10 @@ vector<Vertex<Node>*> cleanEdgesNVertex(Graph<Node> graph, Vertex<Node>* garage)
         v->setVisited(false);
     }
     //--------------------GET CFC----------------------------
-    graph.DepthFirstSearch(garage, visitedVertex);
+    for(auto garage : garages){
+        if(!garage->getVisited())
+            graph.DepthFirstSearch(garage, visitedVertex);
+    }
 
     sort(visitedVertex.begin(),visitedVertex.end(),sortById);
 
@@ -214,16 +574,9 @@ vector<Vertex<Node>*> cleanEdgesNVertex(Graph<Node> graph, Vertex<Node>* garage)
 }
 
 
-Service readService(vector<Vertex<Node>*> graph, string city) {
-
+string askServiceFile(string city) {
     string aux;
     ifstream serviceFile;
-    vector<int> notFound;
-    vector<Vertex<Node>*> pRecolha;
-
-    int id, total = 0;
-    bool found = false;
-
     do {
         cout << "Insert the target service file name (no need for the directory and sufix but MUST be .txt): " << endl;
         cin >> aux;
@@ -233,6 +586,22 @@ Service readService(vector<Vertex<Node>*> graph, string city) {
             cout << "Couldn't open file! Please insert another one." << endl;
 
     } while (!serviceFile);
+    return aux;
+}
+
+Service readService(vector<Vertex<Node>*> graph, string city, string file) {
+
+    string aux;
+    ifstream serviceFile;
+    vector<int> notFound;
+    vector<Vertex<Node>*> pRecolha;
+
+    int id, total = 0;
+    bool found = false;
+
+    if (file.empty())
+        file = askServiceFile(city);
+    serviceFile.open(file);
 
     //------------------FACTORY VERTEX ID-----------------------
 
@@ -300,29 +669,302 @@ Service readService(vector<Vertex<Node>*> graph, string city) {
     }
 
     Service service(1,garage,factory,pRecolha);
+    service.setCity(city);
     return service;
 }
 
 
-double pathCost(Graph<Node> graph, Vertex<Node> * origem, Vertex<Node> * destino, unsigned int algoritmo){
-    double cost = 0;
+vector<int> readServiceIds(string file) {
+    vector<int> ids;
+    ifstream serviceFile(file);
+    string aux;
+    int id;
+    if (!(serviceFile >> id))
+        return ids;
+    ids.push_back(id);          // factory
+    getline(serviceFile, aux);
+    getline(serviceFile, aux);  // number of pickup points
+    while (serviceFile >> id)
+        ids.push_back(id);
+    return ids;
+}
+
+vector<int> readGarageIds(string city) {
+    vector<int> ids;
+    ifstream cityFile("../files/" + city + "/" + city + "_info.txt");
+    string aux;
+    int id;
+    getline(cityFile, aux);
+    aux.erase(remove(aux.begin(), aux.end(), ','), aux.end());  //removes ','
+    stringstream garageStream(aux);
+    while (garageStream >> id)
+        ids.push_back(id);
+    return ids;
+}
+
+bool loadServiceRegion(Graph<Node> &graph, TiledMap &tiles, string city, string file, vector<Vertex<Node>*> &conexo) {
+    vector<int> ids = readServiceIds(file);
+    if (ids.empty())
+        return false;
+    for (auto id : readGarageIds(city))
+        ids.push_back(id);
+    tiles.loadAround(graph, ids, REGION_MARGIN);
+
+    // closures and the CFC are recomputed every time the region grows
+    vector<Vertex<Node>*> points;
+    do {
+        conexo = readFromCityFile(graph, city, true);
+        if (conexo.empty())
+            return false;
+        points.clear();
+        vector<Vertex<Node>*> vertexSet = graph.getVertexSet();
+        for (auto id : ids) {
+            Vertex<Node>* v = vertexBinarySearch(vertexSet, Node(id), 0, vertexSet.size() - 1);
+            if (v != nullptr) points.push_back(v);
+        }
+    } while (tiles.expandForPoints(graph, points) > 0);
+    clearDepotPartition(city);
+    return true;
+}
+
+static map<string, vector<int>> depotPartitions;    // nearest garage of each vertex, per city
+
+const vector<int> & getDepotPartition(Graph<Node> &graph, string city){
+    auto it = depotPartitions.find(city);
+    if(it != depotPartitions.end())
+        return it->second;
+
+    vector<Node> sources;
+    for(auto garage : getGarages(graph))
+        sources.push_back(garage->getInfo());
+    return depotPartitions[city] = graph.multiSourceShortestPath(sources);
+}
+
+void clearDepotPartition(string city){
+    depotPartitions.erase(city);
+}
+
+vector<Vertex<Node>*> getGarages(Graph<Node> &graph){
+    vector<Vertex<Node>*> garages;
+    for(auto v : graph.getVertexSet()){
+        if(v->getInfo().getType()==Type::GARAGEM)
+            garages.push_back(v);
+    }
+    return garages;
+}
+
+vector<Service> splitServiceByDepot(const Service &service, Graph<Node> &graph, string city){
+    vector<Service> services;
+    vector<Vertex<Node>*> garages = getGarages(graph);
+    if(garages.size() <= 1){
+        services.push_back(service);
+        return services;
+    }
+
+    const vector<int> & partition = getDepotPartition(graph, city);
+    vector<vector<Vertex<Node>*>> assigned(garages.size());
+    for(auto p : service.getPontosRecolha()){
+        int depot = partition[p->posAtVec];
+        assigned[depot < 0 ? 0 : depot].push_back(p);
+    }
+
+    for(int i = 0; i < garages.size(); i++){
+        if(assigned[i].empty()) continue;
+        services.push_back(Service(services.size() + 1, garages[i], service.getDestino(), assigned[i]));
+        services.back().setCity(service.getCity());
+    }
+    return services;
+}
+
+double pathCost(Graph<Node> &graph, Vertex<Node> * origem, Vertex<Node> * destino, unsigned int algoritmo){
     if (algoritmo == 0) graph.dijkstraShortestPath(origem->getInfo());
     if (algoritmo == 1) graph.bellmanFordShortestPath(origem->getInfo());
-    vector<Node> path = graph.getPath(origem->getInfo(), destino->getInfo());
-    for (int i = 0; i < graph.getPath(origem->getInfo(), destino->getInfo()).size() - 1; i++) {
-        Vertex<Node> *v1 = graph.findVertex(path[i]);
-        Vertex<Node> *v2 = graph.findVertex(path[i + 1]);
-        for (auto j: v1->getAdj()) {
-            if (j.getDest() == v2) {
-                cost += j.getWeight();
-            }
+    if (algoritmo == 5) corridorSearch(graph, origem, destino);
+    vector<uint32_t> path;
+    return graph.appendPath(destino, path);
+}
+
+void compareRelaxKernels(const Graph<Node> &graph){
+    StaticGraph staticGraph(graph);
+    unsigned n = staticGraph.getNumVertex();
+    if (n == 0)
+        return;
+    vector<RelaxKernel> kernels = {relaxScalar};
+    vector<string> names = {"scalar"};
+    if (getRelaxKernel() != relaxScalar) {
+        kernels.push_back(getRelaxKernel());
+        names.push_back("AVX2");
+    }
+    else
+        cout << "This processor does not support AVX2, only the scalar kernel can be measured.\n";
+
+    vector<vector<double>> results(kernels.size());
+    for (unsigned k = 0; k < kernels.size(); k++) {
+        vector<double> dist;
+        vector<unsigned> parent;
+        unsigned long long relaxed = 0;
+        double seconds = 0;
+        for (unsigned i = 0; i < BENCHMARK_SOURCES; i++) {
+            auto start = chrono::steady_clock::now();
+            relaxed += staticGraph.shortestPath((unsigned long long) i * n / BENCHMARK_SOURCES, dist, parent, kernels[k]);
+            seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            results[k].insert(results[k].end(), dist.begin(), dist.end());
         }
+        cout << names[k] << ": " << relaxed << " edges relaxed in " << seconds * 1000 << " ms ("
+             << relaxed / seconds / 1e6 << " million edges/s)" << endl;
+    }
+    if (kernels.size() > 1)
+        cout << (results[0] == results[1] ? "Both kernels found the same distances." : "The kernels found different distances!") << endl;
+
+    // distance table between BENCHMARK_SOURCES vertices, one search per row against batched searches
+    vector<unsigned> points;
+    for (unsigned i = 0; i < BENCHMARK_SOURCES; i++)
+        points.push_back((unsigned long long) i * n / BENCHMARK_SOURCES);
+    vector<vector<double>> tables;
+    for (bool batched : {false, true}) {
+        auto start = chrono::steady_clock::now();
+        tables.push_back(staticGraph.distanceTable(points, points, batched));
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << (batched ? "Batched table (" + to_string(BATCH_LANES) + " sources per search): " : "Table with one search per source: ")
+             << seconds * 1000 << " ms" << endl;
+    }
+    cout << (tables[0] == tables[1] ? "Both tables are equal." : "The tables are different!") << endl;
+
+    // hop counts: one breadth-first search per source against the bit-parallel table
+    vector<vector<unsigned>> hops(2);
+    auto start = chrono::steady_clock::now();
+    for (auto p : points) {
+        vector<unsigned> row = staticGraph.hopDistances(p);
+        for (auto q : points)
+            hops[0].push_back(row[q]);
+    }
+    double separate = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    start = chrono::steady_clock::now();
+    hops[1] = staticGraph.hopTable(points, points);
+    double bitParallel = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Hop table with one search per source: " << separate * 1000 << " ms, bit-parallel: " << bitParallel * 1000 << " ms ("
+         << (hops[0] == hops[1] ? "equal" : "different!") << ")" << endl;
+
+    StaticGraph reverse = staticGraph.reversed();
+    double topDownTime = 0, optimisedTime = 0;
+    bool equal = true;
+    for (auto p : points) {
+        start = chrono::steady_clock::now();
+        vector<unsigned> topDown = staticGraph.hopDistances(p);
+        topDownTime += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        start = chrono::steady_clock::now();
+        vector<unsigned> optimised = staticGraph.hopDistances(p, &reverse);
+        optimisedTime += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        equal = equal && topDown == optimised;
+    }
+    cout << "Breadth-first searches, top-down: " << topDownTime * 1000 << " ms, direction-optimising: " << optimisedTime * 1000 << " ms ("
+         << (equal ? "equal" : "different!") << ")" << endl;
+}
+
+static unsigned corridorQueries = 0, corridorFallbacks = 0;
+
+void corridorSearch(Graph<Node> &graph, Vertex<Node> * origem, Vertex<Node> * destino, CancelToken *cancel){
+    Node a = origem->getInfo(), b = destino->getInfo();
+    double maxLength = CORRIDOR_STRETCH * getEdgeWeight(a.getXCoord(), a.getYCoord(), b.getXCoord(), b.getYCoord()) + CORRIDOR_SLACK;
+    corridorQueries++;
+    if (!graph.corridorShortestPath(a, b, maxLength, cancel) && (cancel == nullptr || !cancel->isCancelled())) {
+        corridorFallbacks++;
+        graph.dijkstraShortestPath(a, cancel);
+    }
+}
+
+void resetCorridorStats(){
+    corridorQueries = 0;
+    corridorFallbacks = 0;
+}
+
+unsigned getCorridorQueries(){
+    return corridorQueries;
+}
+
+unsigned getCorridorFallbacks(){
+    return corridorFallbacks;
+}
+
+static LegCache legCache;
+static SingleFlight legFlights;
+
+LegCache &getLegCache(){
+    return legCache;
+}
+
+SingleFlight &getLegFlights(){
+    return legFlights;
+}
+
+/*
+ * Version of a graph for the leg cache keys: it changes when tiles are loaded into the graph.
+ */
+static uint64_t graphVersion(const Graph<Node> &graph){
+    return (uint64_t) graph.getNumVertex() << 32 | graph.getNumRoads();
+}
+
+/*
+ * Positions in the vertexSet of the nodes of a leg, false if some node is not loaded in this graph.
+ */
+static bool legPositions(const vector<Vertex<Node> *> &vertexSet, const vector<int> &ids, vector<uint32_t> &leg){
+    leg.clear();
+    for (auto id : ids) {
+        auto it = lower_bound(vertexSet.begin(), vertexSet.end(), id, [](Vertex<Node> *v, int id) { return v->getInfo().getId() < id; });
+        if (it == vertexSet.end() || (*it)->getInfo().getId() != id)
+            return false;
+        leg.push_back((*it)->posAtVec);
     }
+    return !leg.empty();
+}
 
+static double searchLeg(Graph<Node> &graph, const vector<Vertex<Node> *> &vertexSet, Vertex<Node> * origem,
+                        Vertex<Node> * destino, unsigned int algoritmo, vector<int> &ids, CancelToken *cancel){
+    if (algoritmo == 1) graph.bellmanFordShortestPath(origem->getInfo(), cancel);
+    else if (algoritmo == 5) corridorSearch(graph, origem, destino, cancel);
+    else graph.dijkstraShortestPath(origem->getInfo(), cancel);
+    ids.clear();
+    if (cancel != nullptr && cancel->isCancelled())
+        return INF;
+    vector<uint32_t> leg;
+    double cost = graph.appendPath(destino, leg);
+    for (auto pos : leg)
+        ids.push_back(vertexSet[pos]->getInfo().getId());
+    return cost;
+}
+
+double cachedLeg(Graph<Node> &graph, const vector<Vertex<Node> *> &vertexSet, const string &city,
+                 Vertex<Node> * origem, Vertex<Node> * destino, unsigned int algoritmo, vector<uint32_t> &path,
+                 CancelToken *cancel){
+    LegKey key(city, graphVersion(graph), origem->getInfo().getId(), destino->getInfo().getId(), WEIGHTS_DISTANCE);
+    vector<uint32_t> leg;
+    double cost;
+    vector<int> ids;
+    // a leg found with another graph of the city may go through nodes not loaded in this one
+    if (!legCache.lookup(key, cost, ids) || !legPositions(vertexSet, ids, leg)) {
+        bool shared = legFlights.run(key, [&](vector<int> &result) {
+            double c = searchLeg(graph, vertexSet, origem, destino, algoritmo, result, cancel);
+            if (c != INF)
+                legCache.insert(key, c, result);
+            return c;
+        }, cost, ids);
+        if (shared && (cost == INF || !legPositions(vertexSet, ids, leg))) {
+            // the search was shared with a thread using a graph with other nodes loaded,
+            // or interrupted by that thread's token
+            cost = searchLeg(graph, vertexSet, origem, destino, algoritmo, ids, cancel);
+        }
+        if (cost == INF)
+            return INF;
+        legPositions(vertexSet, ids, leg);
+    }
+    // the leg starts where the path ends
+    path.insert(path.end(), leg.begin() + (!path.empty() && path.back() == leg.front() ? 1 : 0), leg.end());
     return cost;
 }
 
-vector<Vertex<Node> *>sortPoints(Service service, Graph<Node> graph, unsigned int algoritmo){
+vector<Vertex<Node> *>sortPoints(const Service &service, Graph<Node> graph, unsigned int algoritmo, CancelToken *cancel){
+    vector<Vertex<Node> *> vertexSet = graph.getVertexSet();
+    vector<uint32_t> leg;
     vector<Vertex<Node> *> pontosrecolha = service.getPontosRecolha();
     vector<Vertex<Node> *> sortedpoints;
     sortedpoints.push_back(service.getGaragem());
@@ -337,7 +979,8 @@ vector<Vertex<Node> *>sortPoints(Service service, Graph<Node> graph, unsigned in
         for (auto i: pontosrecolha) {
             if (find(visited.begin(), visited.end(), i) != visited.end()) continue;
             else {
-                pathcost = pathCost(graph, last, i, algoritmo);
+                pathcost = cachedLeg(graph, vertexSet, service.getCity(), last, i, algoritmo, leg, cancel);
+                leg.clear();
                 if (pathcost < cost) {
                     cost = pathcost;
                     next = i;
@@ -345,50 +988,213 @@ vector<Vertex<Node> *>sortPoints(Service service, Graph<Node> graph, unsigned in
             }
 
         }
+        if (cancel != nullptr && cancel->isCancelled())
+            break;
         sortedpoints.push_back(next);
         last = next;
         visited.push_back(next);
     }
+    // interrupted: the points not sorted yet keep the order of the service
+    for (auto i: pontosrecolha)
+        if (find(visited.begin(), visited.end(), i) == visited.end())
+            sortedpoints.push_back(i);
     sortedpoints.push_back(service.getDestino());
     return sortedpoints;
 
 }
 
-vector<Edge<Node>> orderEdges(Service service, Graph<Node> graph) {
-    vector<Edge<Node>> res;
-    vector<Node> path;
-    vector<Vertex<Node> *> vpontos;
+vector<Vertex<Node> *> sortPointsTimeDependent(const Service &service, Graph<Node> graph, const TimeProfiles &profiles, double departure,
+                                               CancelToken *cancel){
+    vector<Vertex<Node> *> pontosrecolha = service.getPontosRecolha();
+    vector<Vertex<Node> *> sortedpoints;
+    sortedpoints.push_back(service.getGaragem());
+    Vertex<Node> * last = service.getGaragem();
+    double time = departure;
 
-    unsigned int n;
-    do {
+    while (!pontosrecolha.empty()) {
+        // a single search from the last point gives the arrival time at every remaining point
+        graph.timeDependentShortestPath(last->getInfo(), time, profiles, cancel);
+        if (cancel != nullptr && cancel->isCancelled())
+            break;
+        int next = 0;
+        for (int i = 1; i < pontosrecolha.size(); i++) {
+            if (pontosrecolha[i]->getDist() < pontosrecolha[next]->getDist()) next = i;
+        }
+        last = pontosrecolha[next];
+        time = last->getDist();
+        sortedpoints.push_back(last);
+        pontosrecolha.erase(pontosrecolha.begin() + next);
+    }
+    // interrupted: the points not sorted yet keep the order of the service
+    sortedpoints.insert(sortedpoints.end(), pontosrecolha.begin(), pontosrecolha.end());
+    sortedpoints.push_back(service.getDestino());
+    return sortedpoints;
+}
+
+/*
+ * Rows of the distance table used to sort the points: garage and pickups. Columns: pickups and factory.
+ */
+static void tablePoints(const Service &service, vector<unsigned> &sources, vector<unsigned> &targets){
+    sources.push_back(service.getGaragem()->posAtVec);
+    for (auto p: service.getPontosRecolha()) {
+        sources.push_back(p->posAtVec);
+        targets.push_back(p->posAtVec);
+    }
+    targets.push_back(service.getDestino()->posAtVec);
+}
+
+/*
+ * Nearest neighbour order of the pickups given the table built from tablePoints.
+ */
+static vector<Vertex<Node> *> sortPointsByTable(const Service &service, const vector<double> &table){
+    vector<Vertex<Node> *> pontosrecolha = service.getPontosRecolha();
+    vector<Vertex<Node> *> sortedpoints;
+    unsigned m = pontosrecolha.size() + 1;
+
+    vector<bool> visited(pontosrecolha.size(), false);
+    unsigned row = 0;
+    sortedpoints.push_back(service.getGaragem());
+    for (unsigned k = 0; k < pontosrecolha.size(); k++) {
+        int next = -1;
+        for (unsigned j = 0; j < pontosrecolha.size(); j++) {
+            if (!visited[j] && (next < 0 || table[row * m + j] < table[row * m + next])) next = j;
+        }
+        visited[next] = true;
+        sortedpoints.push_back(pontosrecolha[next]);
+        row = next + 1;
+    }
+    sortedpoints.push_back(service.getDestino());
+    return sortedpoints;
+}
 
-        cout << "What algorithm should be used?" << endl;
-        cout << "0 -> Dijkstra's Shortest Path" << endl;
-        cout << "1 -> Bellman-Ford's algorithm" << endl;
-        cout << "Tip: if there are edges with negative weight, Bellman-Ford's algorithm is recommended." << endl;
-        /*cout
-                << "Tip: If the number of edges is about the same as the number of vertex, Dijkstra is recommended but there are way more edges than vertex, Floyd-Warshall is"
-                << endl;*/
-        cout << "Option: ";
-        cin >> n;
+vector<Vertex<Node> *> sortPointsTable(const Service &service, const ContractionHierarchy &ch, CancelToken *cancel){
+    vector<unsigned> sources, targets;
+    tablePoints(service, sources, targets);
+    return sortPointsByTable(service, ch.manyToMany(sources, targets, 0, cancel));
+}
 
-        if (n > 1)
-            cout << endl << endl << "Invalid option! Try again." << endl << endl;
+vector<Vertex<Node> *> sortPointsTable(const Service &service, const StaticGraph &graph, CancelToken *cancel){
+    vector<unsigned> sources, targets;
+    tablePoints(service, sources, targets);
+    return sortPointsByTable(service, graph.distanceTable(sources, targets, true, cancel));
+}
 
-    } while (n > 1);
+vector<Vertex<Node> *> sortPointsTable(const Service &service, const GraphImage &image, CancelToken *cancel){
+    vector<unsigned> sources, targets;
+    tablePoints(service, sources, targets);
+    vector<double> table(sources.size() * targets.size(), INF);
+    vector<double> dist;
+    vector<unsigned> parent;
+    RelaxKernel kernel = getRelaxKernel();
+    for (unsigned i = 0; i < sources.size(); i++) {
+        image.shortestPath(sources[i], dist, parent, kernel, cancel);
+        if (cancel != nullptr && cancel->isCancelled())
+            break;
+        for (unsigned j = 0; j < targets.size(); j++)
+            table[i * targets.size() + j] = dist[targets[j]];
+    }
+    return sortPointsByTable(service, table);
+}
+
+/*
+ * Appends the legs between consecutive points to path, stopping at the first one that cannot be reached or is
+ * interrupted by cancel. Legs found while sorting the points are in the leg cache, so they are still appended
+ * after the deadline.
+ */
+static double appendLegs(Graph<Node> &graph, const vector<Vertex<Node> *> &vertexSet, const string &city,
+                         const vector<Vertex<Node> *> &vpontos, unsigned int algoritmo, vector<uint32_t> &path,
+                         vector<uint32_t> &legStart, vector<float> &legCost, CancelToken *cancel){
+    double cost = 0;
+    for (int i = 0; i < vpontos.size() - 1; i++) {
+        double leg = cachedLeg(graph, vertexSet, city, vpontos[i], vpontos[i + 1], algoritmo, path, cancel);
+        if (leg == INF)
+            break;
+        cost += leg;
+        legStart.push_back(path.size() - 1);
+        legCost.push_back(cost);
+    }
+    return cost;
+}
+
+Route orderEdges(const Service &service, Graph<Node> &graph, RoutingContext &context) {
+    vector<Vertex<Node> *> vertexSet = graph.getVertexSet();
+    vector<uint32_t> path;
+    vector<uint32_t> legStart(1, 0);
+    vector<float> legCost(1, 0);
+    double cost = 0;
+    vector<Vertex<Node> *> vpontos;
+    unsigned int n = context.algoritmo;
+    double departure = context.departure;
+    CancelToken cancel(context.timeLimit);
 
     cout << "\n Working, this may take a while depending on CFC size.\n";
 
     if (n == 0) {
 
-        vpontos = sortPoints(service, graph, n);
+        vpontos = sortPoints(service, graph, n, &cancel);
+        cost = appendLegs(graph, vertexSet, service.getCity(), vpontos, n, path, legStart, legCost, &cancel);
+    }
+    else if (n == 2) {
+
+        vpontos = sortPointsTimeDependent(service, graph, *context.profiles, departure, &cancel);
+        double time = departure;
         for (int i = 0; i < vpontos.size() - 1; i++) {
-            graph.dijkstraShortestPath(vpontos[i]->getInfo());
-            for (auto i: graph.getPath(vpontos[i]->getInfo(), vpontos[i + 1]->getInfo())) {
-                path.push_back(i);
-            }
+            graph.timeDependentAStar(vpontos[i]->getInfo(), vpontos[i + 1]->getInfo(), time, *context.profiles, &cancel);
+            if (cancel.isCancelled())
+                break;
+            double leg = graph.appendPath(vpontos[i + 1], path);
+            if (leg == INF)
+                break;
+            time = vpontos[i + 1]->getDist();
+            cost += leg;
+            legStart.push_back(path.size() - 1);
+            legCost.push_back(cost);
+        }
+        int minutes = (int) (time / 60);
+        if (legStart.size() == vpontos.size())
+            cout << "Expected arrival at the factory: " << (minutes / 60) % 24 << "h" << (minutes % 60 < 10 ? "0" : "") << minutes % 60 << endl;
+    }
+    else if (n == 3) {
+
+        vpontos = sortPoints(service, graph, 0, &cancel);
+        int incoming = -1;
+        for (int i = 0; i < vpontos.size() - 1; i++) {
+            // keep the arriving edge so the van does not turn around at a pickup point
+            if (context.turns->shortestPath(vpontos[i], vpontos[i + 1], incoming, &cancel).empty())
+                context.turns->shortestPath(vpontos[i], vpontos[i + 1], -1, &cancel);
+            if (cancel.isCancelled())
+                break;
+            double leg = context.turns->appendPath(path);
+            if (leg == INF)
+                break;
+            incoming = context.turns->getLastEdge();
+            cost += leg;
+            legStart.push_back(path.size() - 1);
+            legCost.push_back(cost);
         }
     }
+    else if (n == 4) {
+
+        if (context.ch->empty()) {
+            cout << "Building the contraction hierarchy (only needed once per map)...\n";
+            *context.ch = ContractionHierarchy(StaticGraph(graph));
+        }
+        vpontos = sortPointsTable(service, *context.ch, &cancel);
+        cost = appendLegs(graph, vertexSet, service.getCity(), vpontos, n, path, legStart, legCost, &cancel);
+    }
+    else if (n == 6) {
+
+        vpontos = sortPointsTable(service, StaticGraph(graph), &cancel);
+        cost = appendLegs(graph, vertexSet, service.getCity(), vpontos, n, path, legStart, legCost, &cancel);
+    }
+    else if (n == 5) {
+
+        resetCorridorStats();
+        vpontos = sortPoints(service, graph, n, &cancel);
+        cost = appendLegs(graph, vertexSet, service.getCity(), vpontos, n, path, legStart, legCost, &cancel);
+        cout << "Corridor searches: " << getCorridorQueries() << ", " << getCorridorFallbacks() << " needed the full graph ("
+             << (getCorridorQueries() ? 100.0 * getCorridorFallbacks() / getCorridorQueries() : 0) << "%)" << endl;
+    }
     else {
 
         /*for (int i = 0; i < vpontos.size() - 1; i++) {
@@ -397,7 +1203,7 @@ vector<Edge<Node>> orderEdges(Service service, Graph<Node> graph) {
         }
 */
         /*graph.floydWarshallShortestPath();
-        vpontos = sortPoints(service, graph, n);
+        vpontos = sortPoints(service, graph, n, &cancel);
 
         for (int i = 0; i < vpontos.size(); i++)
         {
@@ -405,38 +1211,650 @@ vector<Edge<Node>> orderEdges(Service service, Graph<Node> graph) {
         }*/
 
 
-        vpontos = sortPoints(service, graph, n);
+        vpontos = sortPoints(service, graph, n, &cancel);
 
-        for (int i = 0; i < vpontos.size() - 1; i++) {
-            graph.bellmanFordShortestPath(vpontos[i]->getInfo());
-            for (auto i: graph.getPath(vpontos[i]->getInfo(), vpontos[i + 1]->getInfo())) path.push_back(i);
-        }
+        cost = appendLegs(graph, vertexSet, service.getCity(), vpontos, n, path, legStart, legCost, &cancel);
     }
-    vector<Vertex<Node> *> temp;
-    for (auto i: path){
-        for (auto j: graph.getVertexSet()){
-            if (i == j->getInfo()) temp.push_back(j);
-        }
+    if (n != 2 && n != 3) {
+        cout << "Leg cache: " << legCache.getHits() << " hits, " << legCache.getMisses() << " misses, "
+             << legCache.getEvictions() << " evictions so far" << endl;
+        if (legFlights.getCoalesced() > 0)
+            cout << "Coalesced " << legFlights.getCoalesced() << " of " << legFlights.getSearches() + legFlights.getCoalesced()
+                 << " leg searches, " << legFlights.getWaitTime() / 1000.0 << " ms waiting" << endl;
+    }
+    Route route(path, legStart, legCost);
+    route.setComplete(legStart.size() == vpontos.size());
+    if (cancel.isCancelled())
+        cout << "Time limit reached, keeping the best route found so far (" << legStart.size() - 1 << " of "
+             << vpontos.size() - 1 << " legs)" << endl;
+    else if (!route.isComplete())
+        cout << "There is no path from node " << vpontos[legStart.size() - 1]->getInfo().getId() << " to node "
+             << vpontos[legStart.size()]->getInfo().getId() << ", the route stops there (" << legStart.size() - 1
+             << " of " << vpontos.size() - 1 << " legs)" << endl;
+    return route;
+}
+
+vector<vector<Node>> findAlternatives(Graph<Node> &graph){
+    int idOrig, idDest;
+    unsigned k;
+    vector<vector<Node>> routes;
+
+    cout << "Origin node id: ";
+    cin >> idOrig;
+    cout << "Destination node id: ";
+    cin >> idDest;
+    cout << "How many alternatives (including the shortest route)? ";
+    cin >> k;
+
+    Vertex<Node>* v1 = vertexBinarySearch(graph.getVertexSet(),Node(idOrig),0,graph.getVertexSet().size() - 1);
+    Vertex<Node>* v2 = vertexBinarySearch(graph.getVertexSet(),Node(idDest),0,graph.getVertexSet().size() - 1);
+    if(v1 == nullptr || v2 == nullptr){
+        cout << "Failed to find vertex " << idOrig << " or vertex " << idDest << " !!!\n";
+        return routes;
     }
 
+    routes = graph.alternativeRoutes(v1->getInfo(), v2->getInfo(), k);
+    if(routes.empty()){
+        cout << "There is no route between those nodes!\n";
+        return routes;
+    }
+
+    double shortest = routeCost(graph, routes[0]);
+    for(int i = 0; i < routes.size(); i++){
+        double cost = routeCost(graph, routes[i]);
+        cout << "Route " << i + 1 << ": " << routes[i].size() << " nodes, " << cost << " (+" << (cost / shortest - 1) * 100 << "%)\n";
+    }
+    if(routes.size() < k)
+        cout << "Only " << routes.size() << " sensible alternative(s) found.\n";
+    return routes;
+}
 
-    for (int i = 0; i < temp.size() - 1; i++) {
-        Vertex<Node> *v1 = graph.findVertex(temp[i]->getInfo());
-        Vertex<Node> *v2 = graph.findVertex(temp[i + 1]->getInfo());
-        for (auto j: v1->getAdj()) {
-            if (j.getDest() == v2) {
-                res.push_back(j);
+vector<Isochrone> findIsochrones(Graph<Node> &graph, const TimeProfiles &profiles, Vertex<Node>* &centre){
+    int id, nrRadii;
+    unsigned unit;
+    double departure = 0, radius;
+    vector<double> radii;
+
+    cout << "Centre node id (0 for the garage): ";
+    cin >> id;
+    centre = nullptr;
+    if(id == 0){
+        for(auto v : graph.getVertexSet()){
+            if(v->getInfo().getType() == Type::GARAGEM){
+                centre = v;
                 break;
             }
         }
+    } else {
+        centre = vertexBinarySearch(graph.getVertexSet(),Node(id),0,graph.getVertexSet().size() - 1);
+    }
+    if(centre == nullptr){
+        cout << "Failed to find vertex " << id << " !!!\n";
+        return vector<Isochrone>();
+    }
+
+    do {
+        cout << "Radius unit: 0 -> metres, 1 -> minutes: ";
+        cin >> unit;
+    } while(unit > 1);
+    if(unit == 1){
+        cout << "Departure time, in hours (i.e. 8.5 for 08:30): ";
+        cin >> departure;
+        departure *= 3600;
+    }
+    cout << "How many radii? ";
+    cin >> nrRadii;
+    for(int i = 0; i < nrRadii; i++){
+        cout << "Radius " << i + 1 << ": ";
+        cin >> radius;
+        radii.push_back(unit == 1 ? radius * 60 : radius);
     }
-    return res;
+
+    vector<Isochrone> isochrones = computeIsochrones(graph, centre, radii, 0, unit == 1 ? &profiles : nullptr, departure);
+    for(auto & isochrone : isochrones){
+        cout << "Radius " << (unit == 1 ? isochrone.getRadius() / 60 : isochrone.getRadius()) << (unit == 1 ? " min: " : " m: ")
+             << isochrone.getNodes().size() << " nodes, " << isochrone.getFrontier().size() << " on the frontier, "
+             << isochrone.getBoundary().size() << " boundary segments\n";
+    }
+    return isochrones;
 }
 
-void proccessService(Service &service, Graph<Node> graph){
+double routeCost(Graph<Node> &graph, const vector<Node> &route){
+    double cost = 0;
+    for(int i = 0; i + 1 < route.size(); i++){
+        Vertex<Node>* v1 = vertexBinarySearch(graph.getVertexSet(),route[i],0,graph.getVertexSet().size() - 1);
+        double w = INF;
+        for(auto e : v1->getAdj())
+            if(e.getDest()->getInfo() == route[i + 1] && e.getWeight() < w) w = e.getWeight();
+        cost += w;
+    }
+    return cost;
+}
+
+void proccessService(Service &service, Graph<Node> graph, RoutingContext &context){
     Vehicle vehicle(1);
-    vehicle.setPRordenados(orderEdges(service, graph));
+    vehicle.setRoute(orderEdges(service, graph, context));
+    service.setVehicle(vehicle);
+}
+
+/*
+ * Route through the points of a tour of the matrix, with legs from the leg cache.
+ */
+static Route tourRoute(Graph<Node> &graph, const vector<Vertex<Node> *> &vertexSet, const string &city,
+                       const CostMatrix &matrix, const vector<unsigned> &tour, CancelToken *cancel){
+    vector<Vertex<Node> *> vpontos;
+    for (auto t : tour)
+        vpontos.push_back(matrix.getPoint(t));
+    vector<uint32_t> path;
+    vector<uint32_t> legStart(1, 0);
+    vector<float> legCost(1, 0);
+    appendLegs(graph, vertexSet, city, vpontos, 0, path, legStart, legCost, cancel);
+    Route route(path, legStart, legCost);
+    route.setComplete(legStart.size() == vpontos.size());
+    return route;
+}
+
+void proccessService(Service &service, Graph<Node> &graph, const RouteCallback &onImprovement, CancelToken *cancel){
+    auto start = chrono::steady_clock::now();
+    vector<Vertex<Node> *> vertexSet = graph.getVertexSet();
+    vector<Vertex<Node> *> points(1, service.getGaragem());
+    vector<unsigned> pickups;
+    for (auto p : service.getPontosRecolha()) {
+        pickups.push_back(points.size());
+        points.push_back(p);
+    }
+    points.push_back(service.getDestino());
+
+    CostMatrix matrix(StaticGraph(graph), points, cancel);
+    TourOptimizer optimizer(matrix);
+    vector<unsigned> tour = optimizer.nearestNeighbour(0, pickups, points.size() - 1);
+    unsigned updates = 0;
+    Route best;
+    auto send = [&](bool final) {
+        RouteUpdate update;
+        update.route = best;
+        update.cost = best.getTotalCost();
+        update.elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        update.number = updates++;
+        update.final = final;
+        if (onImprovement)
+            onImprovement(update);
+    };
+    auto publish = [&](const vector<unsigned> &tour) {
+        // the first route is always built in full; a better one whose legs could not all be found before the
+        // deadline is dropped, so every route sent (and the vehicle's) is complete
+        Route route = tourRoute(graph, vertexSet, service.getCity(), matrix, tour, best.empty() ? nullptr : cancel);
+        if (!best.empty() && !route.isComplete())
+            return;
+        best = route;
+        Vehicle vehicle(1);
+        vehicle.setRoute(best);
+        service.setVehicle(vehicle);
+        send(false);
+    };
+    publish(tour);
+    optimizer.optimize(tour, [&](const vector<unsigned> &improved, double) { publish(improved); }, cancel);
+    send(true);
+}
+
+/*
+ * Node ids and positions of a read-only graph indexed as the vertexSet, for the leg cache.
+ */
+static int viewId(const StaticGraph &graph, unsigned v){
+    return graph.getVertex(v)->getInfo().getId();
+}
+
+static int viewId(const GraphImage &image, unsigned v){
+    return image.getNode(v).getId();
+}
+
+static int viewIndex(const StaticGraph &graph, int id){
+    unsigned low = 0, high = graph.getNumVertex();
+    while (low < high) {
+        unsigned mid = (low + high) / 2;
+        if (viewId(graph, mid) < id) low = mid + 1;
+        else high = mid;
+    }
+    return low < graph.getNumVertex() && viewId(graph, low) == id ? (int) low : -1;
+}
+
+static int viewIndex(const GraphImage &image, int id){
+    return image.findVertex(id);
+}
+
+/*
+ * Positions in a view of the nodes of a leg, false if some node is not in it.
+ */
+template <class View>
+static bool viewPositions(const View &graph, const vector<int> &ids, vector<uint32_t> &leg){
+    leg.clear();
+    for (auto id : ids) {
+        int v = viewIndex(graph, id);
+        if (v < 0)
+            return false;
+        leg.push_back(v);
+    }
+    return !leg.empty();
+}
+
+/*
+ * Shortest leg from source to target over a view, as the node ids from source to target; INF if there is no path
+ * or the search is interrupted.
+ */
+template <class View>
+static double viewLeg(const View &graph, unsigned source, unsigned target, RelaxKernel kernel, vector<int> &ids, CancelToken *cancel){
+    vector<double> dist;
+    vector<unsigned> parent;
+    graph.shortestPath(source, dist, parent, kernel, cancel);
+    ids.clear();
+    if ((cancel != nullptr && cancel->isCancelled()) || dist[target] == INF)
+        return INF;
+    for (unsigned v = target; v != source; v = parent[v])
+        ids.push_back(viewId(graph, v));
+    ids.push_back(viewId(graph, source));
+    reverse(ids.begin(), ids.end());
+    return dist[target];
+}
+
+/*
+ * Legs between the sorted points over a read-only graph indexed as the vertexSet (StaticGraph or GraphImage).
+ * Each leg goes through the leg cache and, when another worker is already searching it, waits for that search.
+ * The view is never written, so any number of workers can route over it at once.
+ */
+template <class View>
+static Route viewRoute(const View &graph, const string &city, const vector<Vertex<Node> *> &vpontos, CancelToken *cancel){
+    vector<uint32_t> path(1, vpontos[0]->posAtVec);
+    vector<uint32_t> legStart(1, 0);
+    vector<float> legCost(1, 0);
+    vector<uint32_t> positions;
+    vector<int> ids;
+    RelaxKernel kernel = getRelaxKernel();
+    // the edges of a view are its directed adjacency entries, so these keys are never those of cachedLeg
+    uint64_t version = (uint64_t) graph.getNumVertex() << 32 | graph.getNumEdges();
+    double cost = 0;
+    for (int i = 0; i < vpontos.size() - 1; i++) {
+        unsigned source = vpontos[i]->posAtVec, target = vpontos[i + 1]->posAtVec;
+        LegKey key(city, version, viewId(graph, source), viewId(graph, target), WEIGHTS_DISTANCE);
+        double leg;
+        if (!legCache.lookup(key, leg, ids) || !viewPositions(graph, ids, positions)) {
+            bool shared = legFlights.run(key, [&](vector<int> &result) {
+                double c = viewLeg(graph, source, target, kernel, result, cancel);
+                if (c != INF)
+                    legCache.insert(key, c, result);
+                return c;
+            }, leg, ids);
+            // the search was shared with a worker whose deadline interrupted it
+            if (shared && (leg == INF || !viewPositions(graph, ids, positions)))
+                leg = viewLeg(graph, source, target, kernel, ids, cancel);
+            if (leg == INF)
+                break;
+            viewPositions(graph, ids, positions);
+        }
+        cost += leg;
+        path.insert(path.end(), positions.begin() + 1, positions.end());
+        legStart.push_back(path.size() - 1);
+        legCost.push_back(cost);
+    }
+    Route route(path, legStart, legCost);
+    route.setComplete(legStart.size() == vpontos.size());
+    return route;
+}
+
+Route routeService(const Service &service, const StaticGraph &graph, CancelToken *cancel){
+    return viewRoute(graph, service.getCity(), sortPointsTable(service, graph, cancel), cancel);
+}
+
+Route routeService(const Service &service, const GraphImage &image, CancelToken *cancel){
+    return viewRoute(image, service.getCity(), sortPointsTable(service, image, cancel), cancel);
+}
+
+unsigned insertPickups(Service &service, const StaticGraph &graph, const StaticGraph &reverse,
+                       const vector<Vertex<Node> *> &pickups, CancelToken *cancel){
+    const Route &old = service.getVehicle().getRoute();
+    if (old.empty() || !old.isComplete() || pickups.empty())
+        return 0;
+
+    // the stops of the route, in route order, are the first points of the matrix
+    map<unsigned, Vertex<Node> *> byPosition;
+    byPosition[service.getGaragem()->posAtVec] = service.getGaragem();
+    byPosition[service.getDestino()->posAtVec] = service.getDestino();
+    for (auto p : service.getPontosRecolha())
+        byPosition[p->posAtVec] = p;
+    unsigned legs = old.getNumLegs();
+    vector<Vertex<Node> *> stops;
+    for (unsigned l = 0; l <= legs; l++) {
+        auto it = byPosition.find(old.getVertex(l < legs ? old.getLegBegin(l) : old.getLegEnd(legs - 1)));
+        if (it == byPosition.end())
+            return 0;   // the route does not stop at the points of this service
+        stops.push_back(it->second);
+    }
+
+    CostMatrix matrix(stops);
+    for (unsigned l = 0; l < legs; l++)
+        matrix.setCost(l, l + 1, old.getLegCost(l));
+    vector<unsigned> tour;
+    for (unsigned i = 0; i < stops.size(); i++)
+        tour.push_back(i);
+
+    TourOptimizer optimizer(matrix);
+    vector<vector<unsigned>> forwardParent, backwardParent;     // by matrix index - stops.size()
+    vector<unsigned> inserted;
+    vector<Vertex<Node> *> added;
+    for (auto p : pickups) {
+        if (cancel != nullptr && cancel->poll())
+            break;
+        forwardParent.emplace_back();
+        backwardParent.emplace_back();
+        unsigned index = matrix.addPoint(p, graph, reverse, forwardParent.back(), backwardParent.back(), cancel);
+        if (cancel != nullptr && cancel->isCancelled())
+            break;
+        if (optimizer.insert(tour, index) != INF) {
+            inserted.push_back(index);
+            added.push_back(p);
+        }
+    }
+    // the relocations only look at costs from or to a new point and between stops that follow each other in the
+    // old route, the only ones the matrix knows
+    for (unsigned pass = 0; pass < INSERT_REPAIR_PASSES; pass++) {
+        bool improved = false;
+        for (auto index : inserted)
+            improved = optimizer.relocate(tour, index) || improved;
+        if (!improved)
+            break;
+    }
+    if (inserted.empty())
+        return 0;
+
+    vector<uint32_t> path(1, old.getVertex(0));
+    vector<uint32_t> legStart(1, 0);
+    vector<float> legCost(1, 0);
+    vector<uint32_t> leg;
+    double cost = 0;
+    for (unsigned k = 0; k + 1 < tour.size(); k++) {
+        unsigned a = tour[k], b = tour[k + 1];
+        unsigned from = matrix.getPoint(a)->posAtVec, to = matrix.getPoint(b)->posAtVec;
+        leg.clear();
+        if (a < stops.size() && b == a + 1) {
+            for (unsigned v = old.getLegBegin(a) + 1; v <= old.getLegEnd(a); v++)
+                leg.push_back(old.getVertex(v));
+        }
+        else if (a >= stops.size()) {
+            const vector<unsigned> &parent = forwardParent[a - stops.size()];
+            for (unsigned v = to; v != from; v = parent[v])
+                leg.push_back(v);
+            std::reverse(leg.begin(), leg.end());
+        }
+        else {
+            const vector<unsigned> &parent = backwardParent[b - stops.size()];
+            for (unsigned v = parent[from]; v != to; v = parent[v])
+                leg.push_back(v);
+            if (from != to)
+                leg.push_back(to);
+        }
+        path.insert(path.end(), leg.begin(), leg.end());
+        cost += matrix.cost(a, b);
+        legStart.push_back(path.size() - 1);
+        legCost.push_back(cost);
+    }
+
+    vector<Vertex<Node> *> pontos = service.getPontosRecolha();
+    pontos.insert(pontos.end(), added.begin(), added.end());
+    service.setPontosRecolha(pontos);
+    Vehicle vehicle = service.getVehicle();
+    vehicle.setRoute(Route(path, legStart, legCost));
+    service.setVehicle(vehicle);
+    return inserted.size();
+}
+
+unsigned removePickups(Service &service, Graph<Node> &graph, const vector<Vertex<Node> *> &pickups, CancelToken *cancel){
+    const Route &old = service.getVehicle().getRoute();
+    if (old.empty() || !old.isComplete() || pickups.empty())
+        return 0;
+    vector<Vertex<Node> *> vertexSet = graph.getVertexSet();
+
+    // the stops left, in route order, with their index in the old route; every pickup given removes one stop
+    map<int, int> pending;      // stops still to remove, by node id
+    for (auto p : pickups)
+        pending[p->getInfo().getId()]++;
+    unsigned legs = old.getNumLegs();
+    vector<Vertex<Node> *> stops;
+    vector<unsigned> oldIndex;
+    for (unsigned l = 0; l <= legs; l++) {
+        Vertex<Node> *stop = vertexSet[old.getVertex(l < legs ? old.getLegBegin(l) : old.getLegEnd(legs - 1))];
+        auto it = pending.find(stop->getInfo().getId());
+        if (l == 0 || l == legs || it == pending.end() || it->second == 0) {
+            stops.push_back(stop);
+            oldIndex.push_back(l);
+        }
+        else
+            it->second--;
+    }
+    unsigned removed = legs + 1 - stops.size();
+    if (removed == 0)
+        return 0;
+
+    CostMatrix matrix(stops);
+    map<pair<unsigned, unsigned>, vector<uint32_t>> found;     // vertices of the legs known between stops not consecutive before
+    vector<unsigned> splices;
+    for (unsigned i = 0; i + 1 < stops.size(); i++) {
+        if (oldIndex[i + 1] == oldIndex[i] + 1) {
+            matrix.setCost(i, i + 1, old.getLegCost(oldIndex[i]));
+            continue;
+        }
+        vector<uint32_t> &leg = found[make_pair(i, i + 1)];
+        double cost = cachedLeg(graph, vertexSet, service.getCity(), stops[i], stops[i + 1], 0, leg, cancel);
+        if (cost == INF)
+            return 0;
+        matrix.setCost(i, i + 1, cost);
+        splices.push_back(i + 1);
+    }
+    // the repair may also use any other leg between the stops near a splice that is already cached
+    uint64_t version = graphVersion(graph);
+    for (auto at : splices) {
+        unsigned lo = at > REMOVE_REPAIR_WINDOW ? at - REMOVE_REPAIR_WINDOW : 0;
+        unsigned hi = min<unsigned>(at + REMOVE_REPAIR_WINDOW, stops.size() - 1);
+        for (unsigned i = lo; i <= hi; i++)
+            for (unsigned j = lo; j <= hi; j++) {
+                double cost;
+                vector<int> ids;
+                vector<uint32_t> leg;
+                if (i != j && matrix.cost(i, j) == INF &&
+                    getLegCache().lookup(LegKey(service.getCity(), version, stops[i]->getInfo().getId(), stops[j]->getInfo().getId(), WEIGHTS_DISTANCE), cost, ids) &&
+                    legPositions(vertexSet, ids, leg)) {
+                    matrix.setCost(i, j, cost);
+                    found[make_pair(i, j)] = leg;
+                }
+            }
+    }
+
+    vector<unsigned> tour;
+    for (unsigned i = 0; i < stops.size(); i++)
+        tour.push_back(i);
+    TourOptimizer optimizer(matrix);
+    for (auto at : splices) {
+        // the window is optimised on its own, so its first and last stops stay in place like the garage and the
+        // factory of a whole tour
+        unsigned lo = at > REMOVE_REPAIR_WINDOW ? at - REMOVE_REPAIR_WINDOW : 0;
+        unsigned hi = min<unsigned>(at + REMOVE_REPAIR_WINDOW, stops.size() - 1);
+        vector<unsigned> window(tour.begin() + lo, tour.begin() + hi + 1);
+        for (unsigned pass = 0; pass < REMOVE_REPAIR_PASSES; pass++) {
+            bool improved = optimizer.twoOpt(window);
+            improved = optimizer.orOpt(window) || improved;
+            if (!improved)
+                break;
+        }
+        copy(window.begin(), window.end(), tour.begin() + lo);
+    }
+
+    vector<uint32_t> path(1, old.getVertex(0));
+    vector<uint32_t> legStart(1, 0);
+    vector<float> legCost(1, 0);
+    double cost = 0;
+    for (unsigned k = 0; k + 1 < tour.size(); k++) {
+        unsigned a = tour[k], b = tour[k + 1];
+        if (oldIndex[b] == oldIndex[a] + 1) {
+            for (unsigned v = old.getLegBegin(oldIndex[a]) + 1; v <= old.getLegEnd(oldIndex[a]); v++)
+                path.push_back(old.getVertex(v));
+        }
+        else {
+            // the repair only makes moves with known legs, so this is never a search
+            const vector<uint32_t> &leg = found[make_pair(a, b)];
+            path.insert(path.end(), leg.begin() + 1, leg.end());
+        }
+        cost += matrix.cost(a, b);
+        legStart.push_back(path.size() - 1);
+        legCost.push_back(cost);
+    }
+
+    pending.clear();
+    for (auto p : pickups)
+        pending[p->getInfo().getId()]++;
+    vector<Vertex<Node> *> pontos;
+    for (auto p : service.getPontosRecolha()) {
+        auto it = pending.find(p->getInfo().getId());
+        if (it == pending.end() || it->second == 0)
+            pontos.push_back(p);
+        else
+            it->second--;
+    }
+    service.setPontosRecolha(pontos);
+    Vehicle vehicle = service.getVehicle();
+    vehicle.setRoute(Route(path, legStart, legCost));
+    service.setVehicle(vehicle);
+    return removed;
+}
+
+ServiceDiff diffServices(const Service &previous, const Service &current){
+    ServiceDiff diff;
+    map<int, int> count;     // occurrences in previous minus occurrences in current, by node id
+    for (auto p : previous.getPontosRecolha())
+        count[p->getInfo().getId()]++;
+    for (auto p : current.getPontosRecolha())
+        if (count[p->getInfo().getId()]-- <= 0)
+            diff.added.push_back(p);
+    for (auto p : previous.getPontosRecolha())
+        if (count[p->getInfo().getId()]-- > 0)
+            diff.removed.push_back(p);
+    return diff;
+}
+
+bool warmStart(Service &service, const ServiceRecord &previous, Graph<Node> &graph, const StaticGraph &staticGraph,
+               const StaticGraph &reverse, CancelToken *cancel){
+    if (!previous.isSolved() || previous.getCity() != service.getCity() ||
+        previous.getGaragem() != service.getGaragem()->getInfo().getId() || previous.getDestino() != service.getDestino()->getInfo().getId())
+        return false;
+    // the previous service in this graph, with its route mapped through the node ids
+    Service work(service.getId(), service.getGaragem(), service.getDestino());
+    if (!previous.toService(graph.getVertexSet(), work))
+        return false;
+    Vehicle vehicle = service.getVehicle();
+    if (previous.fingerprint() == service.fingerprint()) {
+        vehicle.setRoute(work.getVehicle().getRoute());
+        service.setVehicle(vehicle);
+        return true;
+    }
+
+    ServiceDiff diff = diffServices(work, service);
+    if (!diff.removed.empty() && removePickups(work, graph, diff.removed, cancel) == 0)
+        return false;
+    if (!diff.added.empty()) {
+        insertPickups(work, staticGraph, reverse, diff.added, cancel);
+        if (cancel != nullptr && cancel->isCancelled())
+            return false;
+    }
+    vehicle.setRoute(work.getVehicle().getRoute());
     service.setVehicle(vehicle);
+    return true;
+}
+
+vector<Service> clusterService(const Service &service, unsigned clusterSize){
+    const Node &garage = service.getGaragem()->getInfo();
+    vector<pair<double, Vertex<Node> *>> sweep;
+    for (auto p : service.getPontosRecolha())
+        sweep.emplace_back(atan2(p->getInfo().getYCoord() - garage.getYCoord(), p->getInfo().getXCoord() - garage.getXCoord()), p);
+    sort(sweep.begin(), sweep.end(), [](const pair<double, Vertex<Node> *> &a, const pair<double, Vertex<Node> *> &b) {
+        return a.first < b.first;
+    });
+    // start the sweep after the widest empty sector, so no cluster straddles it
+    unsigned start = 0;
+    double widest = -1;
+    for (unsigned i = 0; i < sweep.size(); i++) {
+        double gap = i == 0 ? sweep[0].first + 2 * M_PI - sweep.back().first : sweep[i].first - sweep[i - 1].first;
+        if (gap > widest) {
+            widest = gap;
+            start = i;
+        }
+    }
+    rotate(sweep.begin(), sweep.begin() + start, sweep.end());
+
+    vector<Service> clusters;
+    unsigned count = (sweep.size() + max(1u, clusterSize) - 1) / max(1u, clusterSize);
+    for (unsigned c = 0, next = 0; c < count; c++) {
+        unsigned end = (unsigned long long) sweep.size() * (c + 1) / count;
+        vector<Vertex<Node> *> pontos;
+        for (; next < end; next++)
+            pontos.push_back(sweep[next].second);
+        Service cluster(c + 1, service.getGaragem(), service.getDestino(), pontos);
+        cluster.setCity(service.getCity());
+        clusters.push_back(cluster);
+    }
+    return clusters;
+}
+
+/*
+ * Runs the clusters on a scheduler and writes its report and the quality of the clusters (see routeClusters).
+ */
+static void runClusters(vector<Service> &clusters, ServiceScheduler &scheduler, ostream &out){
+    auto start = chrono::steady_clock::now();
+    for (auto &cluster : clusters)
+        scheduler.submit(cluster, CLUSTER_DEADLINE);
+    scheduler.run();
+    double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    scheduler.printReport(out);
+
+    double total = 0, spread = 0;
+    unsigned pickups = 0, unrouted = 0;
+    for (unsigned c = 0; c < clusters.size(); c++) {
+        const ServiceJob &job = scheduler.getJobs()[c];
+        Vehicle vehicle(c + 1, job.service.getVehicle().getRoute());
+        clusters[c].setVehicle(vehicle);
+        // mean distance of the pickups to the centre of the cluster, in map units
+        double x = 0, y = 0, radius = 0;
+        const vector<Vertex<Node> *> &pontos = clusters[c].getPontosRecolha();
+        for (auto p : pontos) {
+            x += p->getInfo().getXCoord() / pontos.size();
+            y += p->getInfo().getYCoord() / pontos.size();
+        }
+        for (auto p : pontos)
+            radius += hypot(p->getInfo().getXCoord() - x, p->getInfo().getYCoord() - y) / pontos.size();
+        out << "Cluster " << clusters[c].getId() << ": " << pontos.size() << " pickup points, mean distance to the centre " << radius;
+        spread += radius * pontos.size();
+        if (job.state == JOB_DONE || job.state == JOB_LATE) {
+            double cost = vehicle.getRoute().getTotalCost();
+            out << ", route length " << cost << endl;
+            total += cost;
+        }
+        else {
+            out << ", " << ServiceScheduler::stateName(job.state) << " (" << vehicle.getRoute().getNumLegs() << " of "
+                << pontos.size() + 1 << " legs)" << endl;
+            unrouted++;
+        }
+        pickups += pontos.size();
+    }
+    out << clusters.size() << " clusters, " << pickups << " pickup points, mean distance to the centre "
+        << (pickups > 0 ? spread / pickups : 0) << ", total route length " << total << ", solved in " << elapsed << " ms" << endl;
+    if (unrouted > 0)
+        out << unrouted << " cluster(s) without a complete route, left out of the total length" << endl;
+}
+
+void routeClusters(vector<Service> &clusters, const StaticGraph &graph, unsigned threads, ostream &out){
+    ServiceScheduler scheduler(graph, threads);
+    runClusters(clusters, scheduler, out);
+}
+
+void routeClusters(vector<Service> &clusters, const GraphImage &image, unsigned threads, ostream &out){
+    ServiceScheduler scheduler(image, threads);
+    runClusters(clusters, scheduler, out);
 }
 
 bool sortById(const Vertex<Node>* a,const Vertex<Node>* d){
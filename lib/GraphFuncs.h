@@ -9,6 +9,55 @@
 #include "Graph.h"
 #include "Node.h"
 #include "Service.h"
+#include "TimeProfiles.h"
+#include "TurnGraph.h"
+#include "Isochrone.h"
+#include "ContractionHierarchy.h"
+#include "TiledMap.h"
+#include "GraphImage.h"
+#include "LegCache.h"
+#include "SingleFlight.h"
+#include "CostMatrix.h"
+#include "TourOptimizer.h"
+#include "ServiceRecord.h"
+#include <functional>
+
+#define REGION_MARGIN 500   // margin around a service when loading only its region, in map units
+#define CORRIDOR_STRETCH 2    // longest detour, relative to the straight line, a corridor search covers
+#define CORRIDOR_SLACK 500      // extra length of the corridor, so short legs are not too narrow
+#define BENCHMARK_SOURCES 20    // searches per kernel when comparing the relaxation kernels
+#define INSERT_REPAIR_PASSES 3  // relocation passes over the new points after inserting them in a route
+#define REMOVE_REPAIR_WINDOW 4  // stops on each side of a removed pickup the repair may reorder
+#define REMOVE_REPAIR_PASSES 3  // 2-opt and Or-opt passes over each window after removing pickups
+#define CLUSTER_SIZE 50         // pickup points per vehicle when a service is split into clusters
+#define CLUSTER_DEADLINE 3600   // seconds each cluster may take when the clusters are routed
+
+/**
+ * Rota enviada pelo modo anytime de proccessService: a primeira é a do vizinho mais próximo e cada uma das
+ * seguintes é melhor do que a anterior.
+ */
+struct RouteUpdate {
+    Route route;
+    double cost;        // comprimento da rota
+    double elapsed;     // milissegundos desde o início do cálculo
+    unsigned number;    // 0 para a rota inicial
+    bool final;         // true para a última, igual à melhor já enviada, quando a pesquisa local termina
+};
+
+typedef function<void(const RouteUpdate &)> RouteCallback;
+
+/**
+ * Opções e estruturas auxiliares do cálculo de uma rota por orderEdges. As escolhas do utilizador são pedidas
+ * por chooseRoutingOptions (Menus), mas podem ser preenchidas diretamente para calcular rotas sem terminal.
+ */
+struct RoutingContext {
+    const TimeProfiles *profiles = nullptr;     // perfis de tempo de viagem (algoritmo 2)
+    TurnGraph *turns = nullptr;                 // grafo de viragens (algoritmo 3)
+    ContractionHierarchy *ch = nullptr;         // construida na primeira utilização se estiver vazia (algoritmo 4)
+    unsigned algoritmo = 0;                     // 0 a 6, ver orderEdges
+    double departure = 0;                       // hora de partida da garagem, em segundos desde a meia-noite (algoritmo 2)
+    double timeLimit = 0;                       // segundos, 0 para não ter limite
+};
 
 
 /**
@@ -20,6 +69,62 @@
  */
 Graph<Node> loadGraph( string city);
 
+/**
+ * Versão paralela de loadGraph, com o mesmo resultado: os ficheiros de nodes e de edges são lidos ao mesmo
+ * tempo, cada um dividido em blocos de linhas inteiras que são interpretados por várias threads, e as listas
+ * de adjacências são construídas sem locks (Graph::addRoads).
+ *
+ * @param city string que indica qual cidade a ler
+ * @param threads número de threads por ficheiro (0 para usar todos os cores)
+ *
+ * @return grafo carregado.
+ */
+Graph<Node> loadGraphParallel(string city, unsigned threads = 0);
+
+/**
+ * Identifica a versão dos ficheiros de nodes e edges de uma cidade pelo seu tamanho e data de modificação, para
+ * saber se os ficheiros gerados a partir deles (imagem do grafo, mapa em tiles) estão desatualizados.
+ *
+ * @param city string que indica qual cidade
+ *
+ * @return hash dos tamanhos e datas dos dois ficheiros, 0 se algum não existir.
+ */
+uint64_t mapSourceStamp(string city);
+
+/**
+ * Abre a imagem partilhada do grafo de uma cidade ("image_<city>.bin", ver GraphImage), construindo-a a partir
+ * dos ficheiros do mapa se ainda não existir ou se tiver sido construída a partir de outra versão desses ficheiros
+ * (mapSourceStamp). Os processos seguintes só têm de a mapear. A imagem não tem as
+ * estradas de comprimento 0, que readFromCityFile retira de qualquer forma.
+ *
+ * @param image imagem a abrir
+ * @param city string que indica qual cidade a ler
+ *
+ * @return false se não for possível abrir nem construir a imagem.
+ */
+bool openCityImage(GraphImage &image, string city);
+
+/**
+ * Constrói um grafo a partir de uma imagem aberta, sem ler os ficheiros de texto do mapa. O grafo tem os mesmos
+ * vertices, nas mesmas posições do vertexSet, e as mesmas estradas que o de loadGraphParallel para a mesma cidade,
+ * menos as de comprimento 0 (só a ordem das arestas de cada vertex pode mudar).
+ *
+ * @param image imagem aberta (openCityImage)
+ * @param threads número de threads usadas para construir as listas de adjacências (0 para usar todos os cores)
+ *
+ * @return grafo carregado, vazio se a imagem não estiver aberta.
+ */
+Graph<Node> loadGraphImage(const GraphImage &image, unsigned threads = 0);
+
+/**
+ * Verifica se uma imagem pode substituir um grafo nas pesquisas: os mesmos nodes, pela mesma ordem, e o mesmo
+ * número de arestas em cada um. Deixa de ser o caso quando se retiram estradas ao grafo depois de o carregar
+ * (estradas cortadas do ficheiro da cidade) ou quando o grafo não foi carregado da imagem.
+ *
+ * @return false se a imagem não estiver aberta ou não corresponder ao grafo.
+ */
+bool imageMatchesGraph(const GraphImage &image, const Graph<Node> &graph);
+
 /**
  * Função que calcula a distancia entre os dois nodes que a edge vai ligar.
  *
@@ -36,20 +141,23 @@ double getEdgeWeight(double x1,double y1, double x2, double y2);
  * Função que limpa todas as arestas inuteis e consequentemente os vertex inacessiveis
  *
  * @param graph grafo a processar
+ * @param garages garagens da cidade
  *
- * @return Vetor com os vertices accessiveis a partir da garagem.
+ * @return Vetor com os vertices accessiveis a partir de alguma garagem.
  */
-vector<Vertex<Node>*> cleanEdgesNVertex(Graph<Node> graph,Vertex<Node>* garage);
+vector<Vertex<Node>*> cleanEdgesNVertex(Graph<Node> graph,vector<Vertex<Node>*> garages);
 
 /**
- * Função que marca a garagem no grafo e utilizando cleanEdgesNVertex retorna o grafo acessivel a partir da mesma
+ * Função que marca as garagens no grafo e utilizando cleanEdgesNVertex retorna o grafo acessivel a partir das mesmas.
+ * A primeira linha do ficheiro da cidade pode conter vários ids de garagens, separados por espaços.
  *
  * @param graph grafo a processar
  * @param city string que indica qual cidade a ler
+ * @param partial true se o grafo só tiver parte do mapa: os cortes de estradas fora da região carregada são ignorados
  *
  * @return Vetor com os vertices accessiveis a partir da garagem.
  */
-vector<Vertex<Node>*> readFromCityFile(Graph<Node> &graph, string city);
+vector<Vertex<Node>*> readFromCityFile(Graph<Node> &graph, string city, bool partial = false);
 
 /**
 
@@ -57,31 +165,309 @@ vector<Vertex<Node>*> readFromCityFile(Graph<Node> &graph, string city);
  *
  * @param graph grafo contendo apenas nodes acessiveis
  * @param city string que indica em qual cidade estamos a trabalhar
+ * @param file caminho do ficheiro do serviço (vazio para perguntar ao utilizador)
  *
  * @return Uma cópia do grafo passado como argumento mas com os pontos de recolha devidamente marcados
  */
-Service readService(vector<Vertex<Node>*> graph, string city);
+Service readService(vector<Vertex<Node>*> graph, string city, string file = "");
+
+/**
+ * Pergunta ao utilizador o nome de um ficheiro de serviço até ser possível abri-lo.
+ *
+ * @param city string que indica em qual cidade estamos a trabalhar
+ *
+ * @return caminho do ficheiro.
+ */
+string askServiceFile(string city);
+
+/**
+ * Lê os ids de um ficheiro de serviço, sem os procurar no grafo.
+ *
+ * @param file caminho do ficheiro
+ *
+ * @return id da fábrica seguido dos ids dos pontos de recolha (vazio se não for possível ler o ficheiro).
+ */
+vector<int> readServiceIds(string file);
+
+/**
+ * Lê os ids das garagens da primeira linha do ficheiro da cidade.
+ *
+ * @param city string que indica qual cidade a ler
+ *
+ * @return ids das garagens.
+ */
+vector<int> readGarageIds(string city);
+
+/**
+ * Carrega do mapa em tiles a região à volta de um serviço (garagens, fábrica e pontos de recolha, mais REGION_MARGIN),
+ * alargando-a até os caminhos mais curtos entre esses pontos estarem todos dentro da região, e recalcula o CFC.
+ *
+ * @param graph grafo parcial onde carregar a região
+ * @param tiles mapa em tiles da cidade, já aberto
+ * @param city string que indica em qual cidade estamos a trabalhar
+ * @param file caminho do ficheiro do serviço
+ * @param conexo vetor onde guardar os vertices acessíveis a partir das garagens
+ *
+ * @return false se o serviço ou o ficheiro da cidade não puderem ser lidos.
+ */
+bool loadServiceRegion(Graph<Node> &graph, TiledMap &tiles, string city, string file, vector<Vertex<Node>*> &conexo);
+
+/**
+ * Função que devolve a partição de Voronoi do grafo pelas garagens da cidade: para cada vertex (pela sua posição
+ * no vertexSet) o indice da garagem mais próxima em getGarages. É calculada com uma única pesquisa a partir
+ * de todas as garagens e guardada em cache por cidade.
+ *
+ * @param graph grafo a processar
+ * @param city string que indica em qual cidade estamos a trabalhar
+ *
+ * @return Vetor com a garagem associada a cada vertex (-1 se nenhuma o alcança).
+ */
+const vector<int> & getDepotPartition(Graph<Node> &graph, string city);
+
+/**
+ * Função que descarta a partição guardada de uma cidade (p.e. depois de voltar a carregar o grafo).
+ *
+ * @param city string que indica a cidade
+ *
+ * @return nothing.
+ */
+void clearDepotPartition(string city);
+
+/**
+ * Função que devolve as garagens do grafo, por ordem de id.
+ *
+ * @param graph grafo a processar
+ *
+ * @return Vetor com os vertices marcados como garagem.
+ */
+vector<Vertex<Node>*> getGarages(Graph<Node> &graph);
+
+/**
+ * Função que divide um serviço em vários, um por garagem, atribuindo cada ponto de recolha à garagem mais próxima.
+ *
+ * @param service serviço a dividir
+ * @param graph grafo a processar
+ * @param city string que indica em qual cidade estamos a trabalhar
+ *
+ * @return Vetor com um serviço por garagem que tenha pontos de recolha atribuidos.
+ */
+vector<Service> splitServiceByDepot(const Service &service, Graph<Node> &graph, string city);
 
 /**
  * Função que ordena as edges a percorrer pelo veiculo
  *
+ * Algoritmos: 0 Dijkstra, 1 Bellman-Ford, 2 A* dependente do tempo, 3 Dijkstra com custos de viragem,
+ * 4 tabela de distâncias com a contraction hierarchy, 5 Dijkstra restrito a um corredor, 6 tabela de distâncias
+ * em lote.
+ *
  * @param service serviço a realizar
  * @param graph grafo a processar
+ * @param context algoritmo, limite de tempo e estruturas auxiliares que o algoritmo escolhido usa
  *
- * @return Vetor com as edges a percorrer, ordenadas.
+ * @return Rota com os vertices a percorrer, ordenados, e o custo de cada perna. Se o limite de tempo for
+ * atingido ou uma perna não tiver caminho, a rota tem só as pernas anteriores e isComplete() é false.
  */
-vector<Edge<Node>> orderEdges(Service service, Graph<Node> graph, vector<Vertex<Node>*> conexo);
+Route orderEdges(const Service &service, Graph<Node> &graph, RoutingContext &context);
 
 /**
  * Função que atribui um caminho (edges) a um veiculo especifico, e esse veiculo a um serviço;
  *
  * @param service serviço a realizar
  * @param graph grafo a processar
+ * @param context opções do cálculo (ver orderEdges)
  *
  * @return nothing.
  */
 
-void proccessService(Service &service, Graph<Node> graph);
+void proccessService(Service &service, Graph<Node> graph, RoutingContext &context);
+
+/**
+ * Modo anytime de proccessService: calcula logo a rota do vizinho mais próximo (a mesma ordem que sortPoints) e
+ * depois melhora-a com pesquisa local (TourOptimizer), enviando cada rota melhor assim que é encontrada. As
+ * distâncias entre os pontos são calculadas de uma só vez numa CostMatrix e as pernas de cada rota vêm da
+ * cache de pernas, pelo que cada melhoria só pesquisa as pernas novas.
+ *
+ * @param service serviço a realizar; o seu veiculo recebe cada rota antes de esta ser enviada
+ * @param graph grafo a processar
+ * @param onImprovement chamada com cada rota (pode ser vazia)
+ * @param cancel token que pode interromper a pesquisa local, ficando a melhor rota encontrada até então; as rotas
+ * melhores cujas pernas não fiquem todas calculadas antes do limite não são enviadas, pelo que todas as rotas
+ * enviadas estão completas
+ */
+void proccessService(Service &service, Graph<Node> &graph, const RouteCallback &onImprovement, CancelToken *cancel = nullptr);
+
+/**
+ * Versão não interativa de orderEdges, que só lê o StaticGraph do grafo e pode por isso ser chamada por várias
+ * threads ao mesmo tempo: ordena os pontos com sortPointsTable e calcula cada perna com StaticGraph::shortestPath.
+ * As pernas passam pela cache de pernas (getLegCache), e uma perna que outra thread esteja a calcular não é
+ * pesquisada de novo: a thread espera pelo resultado dessa pesquisa (getLegFlights).
+ *
+ * @param service serviço a realizar
+ * @param graph StaticGraph do grafo
+ * @param cancel token que pode interromper o cálculo (nullptr para correr até ao fim)
+ *
+ * @return Rota com os vertices a percorrer, ordenados, e o custo de cada perna. Se o cálculo for interrompido
+ * ou uma perna não tiver caminho, a rota tem só as pernas anteriores e isComplete() é false.
+ */
+Route routeService(const Service &service, const StaticGraph &graph, CancelToken *cancel = nullptr);
+
+/**
+ * Versão de routeService que pesquisa diretamente na imagem mapeada do grafo, sem cópia do grafo em memória:
+ * as threads (ou processos) que calculam rotas partilham as páginas da imagem.
+ *
+ * @param service serviço a realizar, com os vertices do grafo carregado da imagem (ver imageMatchesGraph)
+ * @param image imagem aberta do grafo
+ * @param cancel token que pode interromper o cálculo (nullptr para correr até ao fim)
+ *
+ * @return Rota, como a de routeService.
+ */
+Route routeService(const Service &service, const GraphImage &image, CancelToken *cancel = nullptr);
+
+/**
+ * Acrescenta pontos de recolha a um serviço já calculado sem refazer a rota: cada ponto novo entra entre as duas
+ * paragens seguidas onde aumenta menos o custo (inserção mais barata) e no fim cada ponto novo pode ainda mudar
+ * de lugar (TourOptimizer::relocate, INSERT_REPAIR_PASSES passagens). Só são feitas duas pesquisas por ponto
+ * novo, uma no grafo e outra no grafo invertido; os custos entre as paragens antigas vêm da própria rota.
+ *
+ * @param service serviço com a rota do veiculo já calculada; recebe os pontos inseridos e a nova rota
+ * @param graph StaticGraph do grafo
+ * @param reverse graph.reversed()
+ * @param pickups pontos de recolha novos
+ * @param cancel token que pode interromper as pesquisas; os pontos ainda não pesquisados não são inseridos
+ *
+ * @return número de pontos inseridos (os que não podem ser alcançados a partir da rota, ou dos quais não se
+ * chega à rota, ficam de fora).
+ */
+unsigned insertPickups(Service &service, const StaticGraph &graph, const StaticGraph &reverse,
+                       const vector<Vertex<Node> *> &pickups, CancelToken *cancel = nullptr);
+
+/**
+ * Retira pontos de recolha de um serviço já calculado sem refazer a rota: as paragens de cada lado de um ponto
+ * retirado passam a ser ligadas diretamente (cachedLeg, que só pesquisa se a perna não estiver em cache) e depois
+ * só as REMOVE_REPAIR_WINDOW paragens de cada lado da ligação podem mudar de ordem (2-opt e Or-opt). Essa
+ * reparação só usa pernas que já estão na cache de pernas, pelo que nunca faz pesquisas; o resto da rota fica igual.
+ *
+ * @param service serviço com a rota do veiculo já calculada; perde os pontos retirados e recebe a nova rota
+ * @param graph grafo do serviço
+ * @param pickups pontos de recolha a retirar, comparados pelo id do node; cada um retira uma só paragem (um ponto
+ * repetido no serviço tem de ser dado tantas vezes quantas deve sair)
+ * @param cancel token que pode interromper a pesquisa de uma ligação; a rota e os pontos não mudam
+ *
+ * @return número de paragens retiradas da rota.
+ */
+unsigned removePickups(Service &service, Graph<Node> &graph, const vector<Vertex<Node> *> &pickups, CancelToken *cancel = nullptr);
+
+/**
+ * Diferença entre os pontos de recolha de dois serviços.
+ */
+struct ServiceDiff {
+    vector<Vertex<Node> *> added;       // pontos do serviço novo que o anterior não tinha
+    vector<Vertex<Node> *> removed;     // pontos do serviço anterior que o novo já não tem
+};
+
+/**
+ * @param previous serviço anterior
+ * @param current serviço novo
+ *
+ * @return pontos acrescentados e retirados, comparados pelo id do node (um ponto repetido conta as vezes que aparece).
+ */
+ServiceDiff diffServices(const Service &previous, const Service &current);
+
+/**
+ * Calcula a rota de um serviço a partir da de um serviço anterior da mesma cidade, com a mesma garagem e a mesma
+ * fábrica: se as impressões digitais forem iguais a rota é reutilizada tal como está; senão são retirados os
+ * pontos que saíram (removePickups) e inseridos os que entraram (insertPickups), pelo que só são pesquisadas as
+ * linhas e colunas da matriz dos pontos novos e as ligações que ainda não estão na cache de pernas.
+ *
+ * @param service serviço a realizar; recebe a rota se o arranque a partir do anterior for possível
+ * @param previous serviço anterior calculado (ServiceRecord, por exemplo lido de um ficheiro); a garagem, a fábrica
+ * e a rota são comparadas e mapeadas para este grafo pelos ids dos nodes
+ * @param graph grafo dos serviços
+ * @param staticGraph StaticGraph do grafo
+ * @param reverse staticGraph.reversed()
+ * @param cancel token que pode interromper as pesquisas
+ *
+ * @return false se o serviço anterior não servir (outra cidade, garagem ou fábrica, rota por calcular, nodes que
+ * não estão neste grafo), se os pontos que saíram não puderem ser retirados ou se as pesquisas forem
+ * interrompidas; o serviço fica então sem rota nova e tem de ser calculado do zero.
+ */
+bool warmStart(Service &service, const ServiceRecord &previous, Graph<Node> &graph, const StaticGraph &staticGraph,
+               const StaticGraph &reverse, CancelToken *cancel = nullptr);
+
+/**
+ * Divide os pontos de recolha de um serviço grande em grupos para veiculos diferentes, varrendo-os por ângulo à
+ * volta da garagem (sweep): os pontos são ordenados pelo ângulo, começando a seguir ao maior intervalo entre
+ * ângulos, e cortados em grupos seguidos com o mesmo número de pontos (a menos de um), cada um com no máximo
+ * clusterSize pontos. Assim cada grupo ocupa um setor à volta da garagem e as rotas quase não se cruzam.
+ *
+ * @param service serviço a dividir
+ * @param clusterSize número máximo de pontos de recolha por grupo
+ *
+ * @return um serviço por grupo, com ids 1, 2, ... pela ordem do varrimento e a garagem, a fábrica e a cidade do
+ * serviço original.
+ */
+vector<Service> clusterService(const Service &service, unsigned clusterSize = CLUSTER_SIZE);
+
+/**
+ * Calcula a rota de cada grupo de clusterService em paralelo, com um ServiceScheduler (routeService por grupo),
+ * e escreve o relatório do scheduler e a qualidade dos grupos: para cada um, o número de pontos, a distância
+ * média dos pontos ao seu centro e o comprimento da rota (ou o estado do trabalho, se a rota não ficou completa),
+ * e no fim o comprimento total e o tempo gasto.
+ *
+ * @param clusters grupos a calcular; o veiculo de cada um recebe a sua rota
+ * @param graph StaticGraph do grafo
+ * @param threads número de threads (0 para usar todos os cores)
+ * @param out onde escrever o relatório
+ */
+void routeClusters(vector<Service> &clusters, const StaticGraph &graph, unsigned threads, ostream &out);
+
+/**
+ * Versão de routeClusters em que as threads do scheduler pesquisam na imagem mapeada do grafo.
+ *
+ * @param image imagem aberta do grafo dos grupos (ver imageMatchesGraph)
+ */
+void routeClusters(vector<Service> &clusters, const GraphImage &image, unsigned threads, ostream &out);
+
+/**
+ * Função que carrega os perfis de tempo de viagem de uma cidade e os associa às arestas do grafo.
+ * Lê o ficheiro "<city>_profiles.txt" da pasta da cidade; se não existir, gera os perfis com deriveTimeProfiles.
+ *
+ * Formato do ficheiro: primeira linha com a velocidade em fluxo livre (km/h), segunda linha com os
+ * breakpoints em horas, p.e. "(0, 7.5, 9, 17.5, 19)", e depois uma linha por estrada "(id1, id2, f1, f2, ..., fn)"
+ * com um fator por breakpoint. Estradas não listadas circulam sempre em fluxo livre.
+ *
+ * @param graph grafo a processar
+ * @param city string que indica qual cidade a ler
+ *
+ * @return tabela de perfis referida pelas arestas do grafo.
+ */
+TimeProfiles loadTimeProfiles(Graph<Node> &graph, string city);
+
+/**
+ * Função que gera perfis de tempo de viagem a partir de um modelo simples de velocidade:
+ * estradas mais próximas do centro do mapa sofrem mais com as horas de ponta (manhã e fim da tarde).
+ * As estradas são agrupadas em anéis, pelo que apenas existem alguns perfis distintos.
+ *
+ * @param graph grafo a processar
+ *
+ * @return tabela de perfis referida pelas arestas do grafo.
+ */
+TimeProfiles deriveTimeProfiles(Graph<Node> &graph);
+
+/**
+ * Versão dependente do tempo de sortPoints: escolhe sempre o ponto de recolha com a chegada mais cedo,
+ * tendo em conta a hora a que se sai do ponto anterior.
+ *
+ * @param service serviço a realizar
+ * @param graph grafo a processar
+ * @param profiles perfis de tempo de viagem do grafo
+ * @param departure hora de saída da garagem (segundos desde a meia-noite)
+ * @param cancel token que pode interromper a ordenação; os pontos ainda por ordenar ficam pela ordem do serviço
+ *
+ * @return Vetor com a garagem, os pontos de recolha ordenados e a fábrica.
+ */
+vector<Vertex<Node> *> sortPointsTimeDependent(const Service &service, Graph<Node> graph, const TimeProfiles &profiles, double departure,
+                                               CancelToken *cancel = nullptr);
 
 /**
  * Função para usar com o std::sort para ordenar o vetor de nodes;
@@ -106,8 +492,158 @@ bool sortById(const Vertex<Node>* a,const Vertex<Node>* d);
 Vertex<Node>* vertexBinarySearch(vector<Vertex<Node>*> vertexSet, const Node &target, int indInicio, int indFim);
 
 
-vector<Vertex<Node> *>sortPoints(Service service, Graph<Node> graph, unsigned int algoritmo);
+/**
+ * Função que pede ao utilizador dois nodes e calcula rotas alternativas entre eles (Graph::alternativeRoutes),
+ * mostrando o comprimento de cada uma.
+ *
+ * @param graph grafo a processar
+ *
+ * @return Vetor com as rotas encontradas, a primeira é a mais curta.
+ */
+vector<vector<Node>> findAlternatives(Graph<Node> &graph);
+
+/**
+ * Função que pede ao utilizador um node central (garagem por defeito), a unidade e os raios pretendidos,
+ * e calcula as respetivas isócronas numa única pesquisa.
+ *
+ * @param graph grafo a processar
+ * @param profiles perfis de tempo de viagem do grafo (usados quando os raios são em minutos)
+ * @param centre node central escolhido (escrito pela função)
+ *
+ * @return Vetor com uma isócrona por raio, por ordem crescente de raio.
+ */
+vector<Isochrone> findIsochrones(Graph<Node> &graph, const TimeProfiles &profiles, Vertex<Node>* &centre);
 
-double pathCost(Graph<Node> graph, Vertex<Node> * origem, Vertex<Node> * destino, unsigned int algoritmo);
+/**
+ * Função que compara a velocidade dos kernels de relaxação (escalar e vetorial, se o processador o suportar),
+ * fazendo BENCHMARK_SOURCES pesquisas com cada um sobre um StaticGraph do grafo, e mostra as arestas relaxadas
+ * por segundo e se as distâncias obtidas são iguais. Compara também o tempo de uma tabela de distâncias entre
+ * BENCHMARK_SOURCES vertices com uma pesquisa por origem e com pesquisas em lote, e o mesmo para as tabelas de saltos
+ * (pesquisas em largura) e para uma pesquisa em largura com e sem otimização da direção.
+ *
+ * @param graph grafo a processar
+ */
+void compareRelaxKernels(const Graph<Node> &graph);
+
+/**
+ * Função que calcula o comprimento de uma rota dada como sequência de nodes.
+ *
+ * @param graph grafo a processar
+ * @param route sequência de nodes
+ *
+ * @return soma dos pesos das arestas percorridas.
+ */
+double routeCost(Graph<Node> &graph, const vector<Node> &route);
+
+/**
+ * Ordena os pontos de recolha pelo vizinho mais próximo, com uma pesquisa (cachedLeg) por cada par de pontos.
+ *
+ * @param service serviço a realizar
+ * @param graph grafo a processar
+ * @param algoritmo algoritmo das pesquisas (ver cachedLeg)
+ * @param cancel token que pode interromper a ordenação; os pontos ainda por ordenar ficam pela ordem do serviço
+ *
+ * @return Vetor com a garagem, os pontos de recolha ordenados e a fábrica.
+ */
+vector<Vertex<Node> *>sortPoints(const Service &service, Graph<Node> graph, unsigned int algoritmo, CancelToken *cancel = nullptr);
+
+/**
+ * Versão de sortPoints que calcula todas as distâncias de uma só vez com uma tabela muitos-para-muitos
+ * sobre a contraction hierarchy, em vez de uma pesquisa por cada par de pontos.
+ *
+ * @param service serviço a realizar
+ * @param ch contraction hierarchy do grafo
+ * @param cancel token que pode interromper a tabela; os pares em falta contam como inalcançáveis
+ *
+ * @return Vetor com a garagem, os pontos de recolha ordenados e a fábrica.
+ */
+vector<Vertex<Node> *> sortPointsTable(const Service &service, const ContractionHierarchy &ch, CancelToken *cancel = nullptr);
+
+/**
+ * Versão de sortPointsTable que calcula a tabela com pesquisas em lote sobre o StaticGraph do grafo
+ * (StaticGraph::distanceTable), sem precisar de construir a contraction hierarchy.
+ *
+ * @param service serviço a realizar
+ * @param graph StaticGraph do grafo
+ * @param cancel token que pode interromper a tabela; os pares em falta contam como inalcançáveis
+ *
+ * @return Vetor com a garagem, os pontos de recolha ordenados e a fábrica.
+ */
+vector<Vertex<Node> *> sortPointsTable(const Service &service, const StaticGraph &graph, CancelToken *cancel = nullptr);
+
+/**
+ * Versão de sortPointsTable que calcula a tabela sobre a imagem mapeada do grafo, com uma pesquisa por linha.
+ *
+ * @param service serviço a realizar, com os vertices do grafo carregado da imagem
+ * @param image imagem aberta do grafo
+ * @param cancel token que pode interromper a tabela; os pares em falta contam como inalcançáveis
+ *
+ * @return Vetor com a garagem, os pontos de recolha ordenados e a fábrica.
+ */
+vector<Vertex<Node> *> sortPointsTable(const Service &service, const GraphImage &image, CancelToken *cancel = nullptr);
+
+double pathCost(Graph<Node> &graph, Vertex<Node> * origem, Vertex<Node> * destino, unsigned int algoritmo);
+
+/**
+ * Caminho mais curto entre dois vertices com a pesquisa restrita a uma elipse à volta deles, de comprimento
+ * CORRIDOR_STRETCH vezes a distancia em linha reta mais CORRIDOR_SLACK. Se o caminho encontrado não couber na
+ * elipse não é garantidamente o mais curto, e a pesquisa é repetida no grafo inteiro.
+ * O caminho fica guardado nos vertices, como depois de dijkstraShortestPath.
+ *
+ * @param graph grafo a processar
+ * @param origem vertice de partida
+ * @param destino vertice de chegada
+ * @param cancel token que pode interromper a pesquisa (nullptr para correr até ao fim)
+ */
+void corridorSearch(Graph<Node> &graph, Vertex<Node> * origem, Vertex<Node> * destino, CancelToken *cancel = nullptr);
+
+/**
+ * @return cache de pernas partilhada por todas as pesquisas ponto a ponto (cachedLeg).
+ */
+LegCache &getLegCache();
+
+/**
+ * @return registo das pernas a ser calculadas, que junta os pedidos iguais feitos ao mesmo tempo (cachedLeg).
+ */
+SingleFlight &getLegFlights();
+
+/**
+ * Caminho mais curto entre dois vertices, consultando primeiro a cache de pernas. Se a perna não estiver em cache
+ * (ou passar por nodes que não estão carregados no grafo), é calculada com o algoritmo dado (0 Dijkstra,
+ * 1 Bellman-Ford, 5 pesquisa em corredor, outro valor Dijkstra) e guardada. Todos usam os comprimentos das
+ * estradas como pesos, pelo que partilham as mesmas entradas (WEIGHTS_DISTANCE). Se outra thread estiver a
+ * calcular a mesma perna, espera pelo seu resultado em vez de repetir a pesquisa.
+ * As pesquisas escrevem nos vertices do grafo (dist e path), pelo que só uma thread pode usar um grafo de cada
+ * vez; as threads do ServiceScheduler usam routeService, que só lê o grafo e passa pela mesma cache.
+ *
+ * @param graph grafo a processar
+ * @param vertexSet vertexSet do grafo (ordenado por id)
+ * @param city cidade do grafo, parte da chave da cache
+ * @param origem vertice de partida
+ * @param destino vertice de chegada
+ * @param algoritmo algoritmo a usar se a perna não estiver em cache
+ * @param path caminho ao qual acrescentar a perna (posições no vertexSet), sem repetir o vertice de junção
+ * @param cancel token que pode interromper a pesquisa (nullptr para correr até ao fim)
+ *
+ * @return custo da perna, INF se não existir caminho ou a pesquisa for interrompida (nesse caso path não é alterado).
+ */
+double cachedLeg(Graph<Node> &graph, const vector<Vertex<Node> *> &vertexSet, const string &city,
+                 Vertex<Node> * origem, Vertex<Node> * destino, unsigned int algoritmo, vector<uint32_t> &path,
+                 CancelToken *cancel = nullptr);
+
+/**
+ * Recomeça a contagem de pesquisas feitas por corridorSearch.
+ */
+void resetCorridorStats();
+
+/**
+ * @return número de pesquisas feitas por corridorSearch desde a última chamada a resetCorridorStats.
+ */
+unsigned getCorridorQueries();
+
+/**
+ * @return número dessas pesquisas que tiveram de ser repetidas no grafo inteiro.
+ */
+unsigned getCorridorFallbacks();
 #endif //CAL_PROJ_GRAPHFUNCS_H
 
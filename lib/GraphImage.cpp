@@ -0,0 +1,273 @@
+//
+// GraphImage.cpp
+//
+
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include "GraphImage.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+#define IMAGE_MAGIC "CALGRAPH"
+#define IMAGE_VERSION 3
+
+typedef pair<double, unsigned> QueueEntry;
+
+/*
+ * Start of the file. Every array starts at a multiple of 8 bytes from the beginning of the image.
+ */
+struct ImageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numVertex;
+    uint32_t numEdges;
+    uint32_t reserved;
+    uint64_t source;        // stamp of the files the image was built from, 0 if unknown
+    uint64_t firstEdge;     // offsets of the arrays from the beginning of the image
+    uint64_t targets;
+    uint64_t weights;
+    uint64_t ids;
+    uint64_t coords;
+    uint64_t size;
+};
+
+static uint64_t align8(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t) 7;
+}
+
+GraphImage::GraphImage() {}
+
+GraphImage::~GraphImage() {
+    detach();
+}
+
+bool GraphImage::build(const Graph<Node> &graph, string path, uint64_t source) {
+    StaticGraph staticGraph(graph);
+    unsigned n = staticGraph.getNumVertex(), m = staticGraph.getNumEdges();
+
+    ImageHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, IMAGE_MAGIC, 8);
+    header.version = IMAGE_VERSION;
+    header.numVertex = n;
+    header.numEdges = m;
+    header.source = source;
+    header.firstEdge = align8(sizeof(ImageHeader));
+    header.targets = align8(header.firstEdge + (uint64_t) (n + 1) * sizeof(uint32_t));
+    header.weights = align8(header.targets + (uint64_t) m * sizeof(uint32_t));
+    header.ids = align8(header.weights + (uint64_t) m * sizeof(double));
+    header.coords = align8(header.ids + (uint64_t) n * sizeof(int32_t));
+    header.size = header.coords + (uint64_t) 2 * n * sizeof(double);
+
+    vector<char> image(header.size, 0);
+    memcpy(&image[0], &header, sizeof(header));
+    uint32_t *firstEdge = (uint32_t *) &image[header.firstEdge];
+    uint32_t *targets = (uint32_t *) &image[header.targets];
+    double *weights = (double *) &image[header.weights];
+    int32_t *ids = (int32_t *) &image[header.ids];
+    double *coords = (double *) &image[header.coords];
+    for (unsigned v = 0; v <= n; v++)
+        firstEdge[v] = v < n ? staticGraph.edgeBegin(v) : m;
+    for (unsigned e = 0; e < m; e++) {
+        targets[e] = staticGraph.getTarget(e);
+        weights[e] = staticGraph.getWeight(e);
+    }
+    for (unsigned v = 0; v < n; v++) {
+        Node node = staticGraph.getVertex(v)->getInfo();
+        ids[v] = node.getId();
+        coords[2 * v] = node.getXCoord();
+        coords[2 * v + 1] = node.getYCoord();
+    }
+
+    // write to a temporary file first, so a process attaching meanwhile never sees half an image; the name is
+    // unique to the process, so processes building the same image at once do not write to the same file
+#if defined(__linux__) || defined(__APPLE__)
+    string temporary = path + "." + to_string(getpid()) + ".tmp";
+#else
+    string temporary = path + "." + to_string(GetCurrentProcessId()) + ".tmp";
+#endif
+    ofstream out(temporary, ios::binary);
+    if (!out.write(&image[0], image.size())) {
+        out.close();
+        remove(temporary.c_str());
+        return false;
+    }
+    out.close();
+#if !defined(__linux__) && !defined(__APPLE__)
+    remove(path.c_str());   // rename does not replace an existing file on Windows
+#endif
+    if (rename(temporary.c_str(), path.c_str()) != 0) {
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool GraphImage::attach(string path) {
+    detach();
+#if defined(__linux__) || defined(__APPLE__)
+    file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+    struct stat info;
+    if (fstat(file, &info) != 0 || (size_t) info.st_size < sizeof(ImageHeader)) {
+        detach();
+        return false;
+    }
+    size = info.st_size;
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, file, 0);
+    if (mapped == MAP_FAILED) {
+        detach();
+        return false;
+    }
+    base = (const char *) mapped;
+#else
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        file = nullptr;
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || (size_t) fileSize.QuadPart < sizeof(ImageHeader)) {
+        detach();
+        return false;
+    }
+    size = fileSize.QuadPart;
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        detach();
+        return false;
+    }
+    base = (const char *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (base == nullptr) {
+        detach();
+        return false;
+    }
+#endif
+
+    const ImageHeader *header = (const ImageHeader *) base;
+    if (memcmp(header->magic, IMAGE_MAGIC, 8) != 0 || header->version != IMAGE_VERSION || header->size != size) {
+        detach();
+        return false;
+    }
+    numVertex = header->numVertex;
+    numEdges = header->numEdges;
+    source = header->source;
+    firstEdge = (const uint32_t *) (base + header->firstEdge);
+    targets = (const uint32_t *) (base + header->targets);
+    weights = (const double *) (base + header->weights);
+    ids = (const int32_t *) (base + header->ids);
+    coords = (const double *) (base + header->coords);
+    return true;
+}
+
+void GraphImage::detach() {
+#if defined(__linux__) || defined(__APPLE__)
+    if (base != nullptr)
+        munmap((void *) base, size);
+    if (file >= 0)
+        close(file);
+    file = -1;
+#else
+    if (base != nullptr)
+        UnmapViewOfFile(base);
+    if (mapping != nullptr)
+        CloseHandle(mapping);
+    if (file != nullptr)
+        CloseHandle(file);
+    mapping = nullptr;
+    file = nullptr;
+#endif
+    base = nullptr;
+    size = 0;
+    numVertex = numEdges = 0;
+    source = 0;
+}
+
+bool GraphImage::isAttached() const {
+    return base != nullptr;
+}
+
+size_t GraphImage::getSize() const {
+    return size;
+}
+
+uint64_t GraphImage::getSource() const {
+    return source;
+}
+
+unsigned GraphImage::getNumVertex() const {
+    return numVertex;
+}
+
+unsigned GraphImage::getNumEdges() const {
+    return numEdges;
+}
+
+unsigned GraphImage::edgeBegin(unsigned v) const {
+    return firstEdge[v];
+}
+
+unsigned GraphImage::edgeEnd(unsigned v) const {
+    return firstEdge[v + 1];
+}
+
+unsigned GraphImage::getTarget(unsigned e) const {
+    return targets[e];
+}
+
+double GraphImage::getWeight(unsigned e) const {
+    return weights[e];
+}
+
+Node GraphImage::getNode(unsigned v) const {
+    return Node(ids[v], coords[2 * v], coords[2 * v + 1]);
+}
+
+int GraphImage::findVertex(int id) const {
+    const int32_t *it = lower_bound(ids, ids + numVertex, id);
+    if (it == ids + numVertex || *it != id)
+        return -1;
+    return it - ids;
+}
+
+void GraphImage::shortestPath(unsigned source, vector<double> &dist, vector<unsigned> &parent, RelaxKernel kernel, CancelToken *cancel) const {
+    dist.assign(numVertex, INF);
+    parent.resize(numVertex);
+    for (unsigned v = 0; v < numVertex; v++)
+        parent[v] = v;
+    unsigned maxDegree = 0;
+    for (unsigned v = 0; v < numVertex; v++)
+        maxDegree = max(maxDegree, firstEdge[v + 1] - firstEdge[v]);
+    vector<unsigned> improved(maxDegree);
+    unsigned settled = 0;
+
+    priority_queue<QueueEntry, vector<QueueEntry>, greater<QueueEntry>> q;
+    dist[source] = 0;
+    q.push(make_pair(0.0, source));
+    while (!q.empty()) {
+        QueueEntry top = q.top();
+        q.pop();
+        unsigned v = top.second;
+        if (top.first > dist[v])
+            continue;   // stale entry, v was already settled with a shorter distance
+        if (shouldStop(cancel, settled))
+            break;
+        unsigned begin = firstEdge[v], count = firstEdge[v + 1] - begin;
+        unsigned k = kernel(targets + begin, weights + begin, count, dist[v], dist.data(), improved.data());
+        for (unsigned i = 0; i < k; i++) {
+            unsigned w = targets[begin + improved[i]];
+            parent[w] = v;
+            q.push(make_pair(dist[w], w));
+        }
+    }
+}
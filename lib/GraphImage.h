@@ -0,0 +1,121 @@
+//
+// GraphImage.h
+//
+
+#ifndef CAL_PROJ_GRAPHIMAGE_H
+#define CAL_PROJ_GRAPHIMAGE_H
+
+#include <string>
+#include <cstdint>
+#include "StaticGraph.h"
+
+#if !defined(__linux__) && !defined(__APPLE__)
+typedef void *HANDLE;
+#endif
+
+/**
+ * Imagem de um grafo num ficheiro, para ser partilhada por vários processos.
+ *
+ * A imagem guarda as mesmas listas de adjacências compactas de um StaticGraph, mais o id e as coordenadas
+ * de cada node, usando apenas índices e posições relativas ao início do ficheiro (nunca apontadores), pelo
+ * que pode ser mapeada em memória em qualquer endereço. Cada processo mapeia o ficheiro só para leitura: as
+ * páginas são as da cache do sistema operativo, partilhadas por todos, e abrir a imagem não lê o ficheiro.
+ *
+ * A classe é também a vista sobre a imagem: os vertices são identificados pelo seu índice (a posição no
+ * vertexSet do grafo de onde a imagem foi construída) em vez de Vertex<Node>*.
+ */
+class GraphImage {
+public:
+    GraphImage();
+
+    ~GraphImage();
+
+    GraphImage(const GraphImage &) = delete;
+
+    GraphImage &operator=(const GraphImage &) = delete;
+
+    /**
+     * Escreve a imagem de um grafo num ficheiro.
+     *
+     * @param graph grafo a guardar
+     * @param path caminho do ficheiro
+     * @param source identificação dos ficheiros de onde o grafo foi lido, guardada no cabeçalho (ver getSource)
+     *
+     * @return false se não for possível escrever o ficheiro.
+     */
+    static bool build(const Graph<Node> &graph, string path, uint64_t source = 0);
+
+    /**
+     * Mapeia uma imagem só para leitura, largando a que estiver aberta.
+     *
+     * @return false se o ficheiro não existir ou não for uma imagem válida.
+     */
+    bool attach(string path);
+
+    void detach();
+
+    bool isAttached() const;
+
+    /**
+     * @return tamanho da imagem, em bytes.
+     */
+    size_t getSize() const;
+
+    /**
+     * @return identificação dos ficheiros de onde a imagem foi construída (o valor dado a build).
+     */
+    uint64_t getSource() const;
+
+    unsigned getNumVertex() const;
+
+    unsigned getNumEdges() const;
+
+    /**
+     * As arestas que saem do vertex v são [edgeBegin(v), edgeEnd(v)).
+     */
+    unsigned edgeBegin(unsigned v) const;
+
+    unsigned edgeEnd(unsigned v) const;
+
+    unsigned getTarget(unsigned e) const;
+
+    double getWeight(unsigned e) const;
+
+    Node getNode(unsigned v) const;
+
+    /**
+     * @return índice do vertex com o id dado, -1 se não existir.
+     */
+    int findVertex(int id) const;
+
+    /**
+     * Dijkstra a partir de um vertex, como StaticGraph::shortestPath.
+     *
+     * @param source índice do vertex de partida
+     * @param dist recebe a distância de cada vertex (INF se não for alcançável)
+     * @param parent recebe o vertex anterior no caminho mais curto de cada vertex (o próprio para source e os inalcançáveis)
+     * @param kernel kernel de relaxação (ver getRelaxKernel)
+     * @param cancel token que pode interromper a pesquisa (nullptr para correr até ao fim)
+     */
+    void shortestPath(unsigned source, vector<double> &dist, vector<unsigned> &parent, RelaxKernel kernel = getRelaxKernel(),
+                      CancelToken *cancel = nullptr) const;
+
+private:
+    const char *base = nullptr;
+    size_t size = 0;
+    const uint32_t *firstEdge = nullptr;
+    const uint32_t *targets = nullptr;
+    const double *weights = nullptr;
+    const int32_t *ids = nullptr;           // sorted, as the vertexSet
+    const double *coords = nullptr;         // x and y of each vertex
+    unsigned numVertex = 0, numEdges = 0;
+    uint64_t source = 0;
+#if defined(__linux__) || defined(__APPLE__)
+    int file = -1;
+#else
+    HANDLE file = nullptr;
+    HANDLE mapping = nullptr;
+#endif
+};
+
+#endif //CAL_PROJ_GRAPHIMAGE_H
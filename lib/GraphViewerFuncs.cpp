@@ -147,7 +147,7 @@ void displayGraphConexo( vector<Vertex<Node>*>& graph){
     gv->rearrange();
 }
 
-void displayService(Service service){
+GraphViewer* displayService(const Service &service, const Graph<Node> &graph){
     int h, w;
     h=w=750;
     double xMin,yMin,xMax,yMax;
@@ -155,8 +155,10 @@ void displayService(Service service){
     xMax=yMax=0;
     double auxX, auxY;
     int auxID =1;
-    for(auto i:service.getVehicle().getPRordenados()){
-        Node node = i.getDest()->getInfo();
+    const Route &route = service.getVehicle().getRoute();
+    vector<Vertex<Node>*> vertexSet = graph.getVertexSet();
+    for(unsigned k = 0; k < route.getNumVertices(); k++){
+        Node node = vertexSet[route.getVertex(k)]->getInfo();
         auxX = node.getXCoord();
         auxY = node.getYCoord();
         if(auxX < xMin){xMin = auxX;}
@@ -213,15 +215,17 @@ void displayService(Service service){
     Vertex<Node>* origem;
     origem=service.getGaragem();
 
-    for(auto i: service.getVehicle().getPRordenados()){
-        auxX = ( i.getDest()->getInfo().getXCoord() - xMin ) * w / (xMax-xMin) ;
-        auxY = ( i.getDest()->getInfo().getYCoord() - yMin ) * h / (yMax-yMin) ;
+    // the route starts at the garage, which is already drawn
+    for(unsigned k = 1; k < route.getNumVertices(); k++){
+        Vertex<Node>* dest = vertexSet[route.getVertex(k)];
+        auxX = ( dest->getInfo().getXCoord() - xMin ) * w / (xMax-xMin) ;
+        auxY = ( dest->getInfo().getYCoord() - yMin ) * h / (yMax-yMin) ;
         auxY = h - auxY;
-        gv->addNode(i.getDest()->getInfo().getId(),(int)auxX,(int)auxY);
-        gv->addEdge(auxID,origem->getInfo().getId(),i.getDest()->getInfo().getId(),EdgeType::DIRECTED);
+        gv->addNode(dest->getInfo().getId(),(int)auxX,(int)auxY);
+        gv->addEdge(auxID,origem->getInfo().getId(),dest->getInfo().getId(),EdgeType::DIRECTED);
         gv->setEdgeThickness(auxID,2);
         gv->setEdgeLabel(auxID,to_string(auxID));
-        origem=i.getDest();
+        origem=dest;
         auxID++;
     }
 
@@ -237,5 +241,145 @@ void displayService(Service service){
     }
 
     gv->rearrange();
+    return gv;
+}
+
+void displayAlternatives(vector<vector<Node>> & routes){
+    int h = 750;
+    int w;
+    double xMin,yMin,xMax,yMax;
+    xMin=yMin=DBL_MAX;
+    xMax=yMax=0;
+    int auxX, auxY;
+    int auxID=1;
+    vector<string> colors = {"GREEN", "ORANGE", "MAGENTA", "CYAN", "PINK", "YELLOW"};
+
+    if(routes.empty()) return;
+
+    for(auto & route : routes){
+        for(auto & node : route){
+            if(node.getXCoord() < xMin){xMin = node.getXCoord();}
+            if(node.getYCoord() < yMin){yMin = node.getYCoord();}
+            if(node.getXCoord() > xMax){xMax = node.getXCoord();}
+            if(node.getYCoord() > yMax){yMax = node.getYCoord();}
+        }
+    }
+
+    //----------------SET WIDTH------------
+
+    w = (int) ((xMax-xMin)*h/(yMax-yMin));
+
+    //------------------CREATE GRAPH------------
+
+    GraphViewer* gv = new GraphViewer(w,h,false);
+    gv->createWindow(w,h);
+    gv->defineVertexColor("LIGHT_GRAY");
+    gv->defineEdgeCurved(false);
+    gv->defineVertexSize(5);
+
+    //------------------ADD ROUTES, SHORTEST LAST SO IT STAYS ON TOP----------------
+    vector<int> added;
+    for(int r = routes.size() - 1; r >= 0; r--){
+        for(int i = 0; i < routes[r].size(); i++){
+            Node node = routes[r][i];
+            if(find(added.begin(), added.end(), node.getId()) == added.end()){
+                auxX = ( node.getXCoord() - xMin ) * w / (xMax-xMin) ;
+                auxY = ( node.getYCoord() - yMin ) * h / (yMax-yMin) ;
+                auxY = h - auxY;
+                gv->addNode(node.getId(), auxX, auxY);
+                added.push_back(node.getId());
+            }
+            if(i > 0){
+                gv->addEdge(auxID, routes[r][i - 1].getId(), node.getId(), EdgeType::DIRECTED);
+                gv->setEdgeColor(auxID, colors[r % colors.size()]);
+                gv->setEdgeThickness(auxID, r == 0 ? 4 : 2);
+                auxID++;
+            }
+        }
+    }
 
+    Node orig = routes[0].front(), dest = routes[0].back();
+    gv->setVertexSize(orig.getId(),30);
+    gv->setVertexColor(orig.getId(),"BLUE");
+    gv->setVertexLabel(orig.getId(),"ORIGIN");
+    gv->setVertexSize(dest.getId(),30);
+    gv->setVertexColor(dest.getId(),"RED");
+    gv->setVertexLabel(dest.getId(),"DESTINATION");
+
+    gv->rearrange();
+}
+
+void displayIsochrones(vector<Isochrone> & isochrones, Vertex<Node>* centre){
+    int h = 750;
+    int w;
+    double xMin,yMin,xMax,yMax;
+    xMin=yMin=DBL_MAX;
+    xMax=yMax=-DBL_MAX;
+    int auxX, auxY;
+    int auxID=1;
+    int boundaryID=-1;  // contour points are not map nodes, they get negative ids
+    vector<string> colors = {"RED", "ORANGE", "YELLOW", "GREEN", "CYAN", "BLUE"};
+
+    if(isochrones.empty() || isochrones.back().getNodes().empty()) return;
+
+    for(auto & segment : isochrones.back().getBoundary()){
+        xMin = min(xMin, min(segment.x1, segment.x2));
+        yMin = min(yMin, min(segment.y1, segment.y2));
+        xMax = max(xMax, max(segment.x1, segment.x2));
+        yMax = max(yMax, max(segment.y1, segment.y2));
+    }
+    for(auto v : isochrones.back().getNodes()){
+        xMin = min(xMin, v->getInfo().getXCoord());
+        yMin = min(yMin, v->getInfo().getYCoord());
+        xMax = max(xMax, v->getInfo().getXCoord());
+        yMax = max(yMax, v->getInfo().getYCoord());
+    }
+
+    //----------------SET WIDTH------------
+
+    w = (int) ((xMax-xMin)*h/(yMax-yMin));
+
+    //------------------CREATE GRAPH------------
+
+    GraphViewer* gv = new GraphViewer(w,h,false);
+    gv->createWindow(w,h);
+    gv->defineEdgeCurved(false);
+    gv->defineVertexSize(5);
+
+    //------------------NODES, COLORED BY THE SMALLEST ISOCHRONE------------
+    unsigned first = 0;
+    for(int r = 0; r < isochrones.size(); r++){
+        const vector<Vertex<Node>*> & nodes = isochrones[r].getNodes();
+        for(; first < nodes.size(); first++){
+            auxX = ( nodes[first]->getInfo().getXCoord() - xMin ) * w / (xMax-xMin) ;
+            auxY = ( nodes[first]->getInfo().getYCoord() - yMin ) * h / (yMax-yMin) ;
+            auxY = h - auxY;
+            gv->addNode(nodes[first]->getInfo().getId(), auxX, auxY);
+            gv->setVertexColor(nodes[first]->getInfo().getId(), colors[r % colors.size()]);
+        }
+    }
+    gv->setVertexSize(centre->getInfo().getId(),30);
+    gv->setVertexColor(centre->getInfo().getId(),"BLACK");
+    gv->setVertexLabel(centre->getInfo().getId(),"CENTRE");
+
+    //------------------CONTOURS------------
+    for(int r = 0; r < isochrones.size(); r++){
+        for(auto & segment : isochrones[r].getBoundary()){
+            auxX = ( segment.x1 - xMin ) * w / (xMax-xMin) ;
+            auxY = h - ( segment.y1 - yMin ) * h / (yMax-yMin) ;
+            gv->addNode(boundaryID, auxX, auxY);
+            gv->setVertexSize(boundaryID, 1);
+            auxX = ( segment.x2 - xMin ) * w / (xMax-xMin) ;
+            auxY = h - ( segment.y2 - yMin ) * h / (yMax-yMin) ;
+            gv->addNode(boundaryID - 1, auxX, auxY);
+            gv->setVertexSize(boundaryID - 1, 1);
+            gv->addEdge(auxID, boundaryID, boundaryID - 1, EdgeType::UNDIRECTED);
+            gv->setEdgeColor(auxID, colors[r % colors.size()]);
+            gv->setEdgeThickness(auxID, 3);
+            boundaryID -= 2;
+            auxID++;
+        }
+    }
+
+    gv->rearrange();
 }
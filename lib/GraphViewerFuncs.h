@@ -9,6 +9,7 @@
 #include "Node.h"
 #include "Graph.h"
 #include "Service.h"
+#include "Isochrone.h"
 #include <cfloat>
 
 /**
@@ -60,8 +61,29 @@ int getMinMaxVector(double &xMin,double &yMin, double &xMax, double &yMax , vect
  * Dá display no graphviewerdo trajeto para realizar um serviço.
  *
  * @param service serviço a processar
+ * @param graph grafo onde a rota do serviço foi calculada
+ *
+ * @return janela onde o serviço foi desenhado.
+ */
+GraphViewer* displayService(const Service &service, const Graph<Node> &graph);
+
+/**
+ * Dá display no graphviewer de várias rotas alternativas entre os mesmos dois pontos, cada uma com a sua cor.
+ *
+ * @param routes rotas a desenhar, a primeira é a mais curta
+ *
+ * @return nada.
+ */
+void displayAlternatives(vector<vector<Node>> & routes);
+
+/**
+ * Dá display no graphviewer de isócronas à volta de um node: os nodes são coloridos pela menor isócrona
+ * a que pertencem e o contorno de cada isócrona é desenhado com arestas.
+ *
+ * @param isochrones isócronas por ordem crescente de raio
+ * @param centre node central
  *
  * @return nada.
  */
-void displayService(Service service);
+void displayIsochrones(vector<Isochrone> & isochrones, Vertex<Node>* centre);
 #endif //CAL_PROJ_GRAPHVIEWERFUNCS_H
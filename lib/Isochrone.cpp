@@ -0,0 +1,126 @@
+//
+// Isochrone.cpp
+//
+
+#include <cfloat>
+#include "Isochrone.h"
+
+Isochrone::Isochrone(double radius) : radius(radius) {}
+
+double Isochrone::getRadius() const {
+    return radius;
+}
+
+const vector<Vertex<Node>*> & Isochrone::getNodes() const {
+    return nodes;
+}
+
+void Isochrone::addNode(Vertex<Node>* node) {
+    nodes.push_back(node);
+}
+
+const vector<Vertex<Node>*> & Isochrone::getFrontier() const {
+    return frontier;
+}
+
+void Isochrone::addFrontier(Vertex<Node>* node) {
+    frontier.push_back(node);
+}
+
+const vector<BoundarySegment> & Isochrone::getBoundary() const {
+    return boundary;
+}
+
+void Isochrone::addSegment(const BoundarySegment & segment) {
+    boundary.push_back(segment);
+}
+
+vector<Isochrone> computeIsochrones(Graph<Node> &graph, Vertex<Node>* centre, vector<double> radii, double cellSize,
+                                    const TimeProfiles *profiles, double departure) {
+    vector<Isochrone> res;
+    if (radii.empty() || centre == nullptr)
+        return res;
+    sort(radii.begin(), radii.end());
+
+    //------------------ONE SEARCH FOR EVERY RADIUS-----------------------
+    vector<Vertex<Node>*> reached = graph.boundedShortestPath(centre->getInfo(), radii.back(), profiles, departure);
+
+    for (auto r : radii) {
+        Isochrone isochrone(r);
+        for (auto v : reached) {
+            if (v->getDist() > r) break;
+            isochrone.addNode(v);
+            for (auto e : v->getAdj()) {
+                if (e.getDest()->getDist() > r) {
+                    isochrone.addFrontier(v);
+                    break;
+                }
+            }
+        }
+        res.push_back(isochrone);
+    }
+
+    //------------------GRID OF MINIMUM DISTANCES-----------------------
+    double xMin = DBL_MAX, yMin = DBL_MAX, xMax = -DBL_MAX, yMax = -DBL_MAX;
+    for (auto v : reached) {
+        xMin = min(xMin, v->getInfo().getXCoord());
+        yMin = min(yMin, v->getInfo().getYCoord());
+        xMax = max(xMax, v->getInfo().getXCoord());
+        yMax = max(yMax, v->getInfo().getYCoord());
+    }
+    if (cellSize <= 0)
+        cellSize = max(1.0, max(xMax - xMin, yMax - yMin) / 40);
+
+    // one empty row and column of cells around the nodes so every contour is closed
+    double x0 = xMin - cellSize, y0 = yMin - cellSize;
+    int nx = (int) ceil((xMax - xMin) / cellSize) + 3;
+    int ny = (int) ceil((yMax - yMin) / cellSize) + 3;
+    vector<double> field(nx * ny, INF);
+    for (auto v : reached) {
+        int gx = (int) round((v->getInfo().getXCoord() - x0) / cellSize);
+        int gy = (int) round((v->getInfo().getYCoord() - y0) / cellSize);
+        field[gy * nx + gx] = min(field[gy * nx + gx], v->getDist());
+    }
+
+    //------------------MARCHING SQUARES FOR EACH RADIUS-----------------------
+    // corners: 0 (i,j), 1 (i+1,j), 2 (i+1,j+1), 3 (i,j+1); cell sides: 0 bottom, 1 right, 2 top, 3 left
+    static const int segments[16][4] = {
+            {-1, -1, -1, -1}, {3, 0, -1, -1}, {0, 1, -1, -1}, {3, 1, -1, -1},
+            {1, 2, -1, -1}, {3, 0, 1, 2}, {0, 2, -1, -1}, {3, 2, -1, -1},
+            {2, 3, -1, -1}, {0, 2, -1, -1}, {0, 1, 2, 3}, {1, 2, -1, -1},
+            {1, 3, -1, -1}, {0, 1, -1, -1}, {0, 3, -1, -1}, {-1, -1, -1, -1}};
+    static const int sideCorners[4][2] = {{0, 1}, {1, 2}, {2, 3}, {3, 0}};
+    static const int cornerOffset[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+
+    for (auto & isochrone : res) {
+        double r = isochrone.getRadius();
+        for (int j = 0; j + 1 < ny; j++) {
+            for (int i = 0; i + 1 < nx; i++) {
+                double value[4];
+                int index = 0;
+                for (int c = 0; c < 4; c++) {
+                    value[c] = field[(j + cornerOffset[c][1]) * nx + i + cornerOffset[c][0]];
+                    if (value[c] <= r) index |= 1 << c;
+                }
+                if (index == 0 || index == 15) continue;
+
+                // point where the radius is crossed on a side, interpolated when both distances are known
+                auto crossing = [&](int side, double &x, double &y) {
+                    int a = sideCorners[side][0], b = sideCorners[side][1];
+                    double t = 0.5;
+                    if (value[a] != INF && value[b] != INF && value[a] != value[b])
+                        t = max(0.0, min(1.0, (r - value[a]) / (value[b] - value[a])));
+                    x = x0 + (i + cornerOffset[a][0] + t * (cornerOffset[b][0] - cornerOffset[a][0])) * cellSize;
+                    y = y0 + (j + cornerOffset[a][1] + t * (cornerOffset[b][1] - cornerOffset[a][1])) * cellSize;
+                };
+                for (int s = 0; s < 4 && segments[index][s] >= 0; s += 2) {
+                    BoundarySegment segment;
+                    crossing(segments[index][s], segment.x1, segment.y1);
+                    crossing(segments[index][s + 1], segment.x2, segment.y2);
+                    isochrone.addSegment(segment);
+                }
+            }
+        }
+    }
+    return res;
+}
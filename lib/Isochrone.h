@@ -0,0 +1,65 @@
+//
+// Isochrone.h
+//
+
+#ifndef CAL_PROJ_ISOCHRONE_H
+#define CAL_PROJ_ISOCHRONE_H
+
+#include "Node.h"
+#include "Graph.h"
+#include "TimeProfiles.h"
+
+/**
+ * Segmento do contorno de uma isócrona, em coordenadas do mapa.
+ */
+struct BoundarySegment {
+    double x1, y1, x2, y2;
+};
+
+/**
+ * Conjunto de nodes a uma distância (ou tempo) máxima de um ponto central, e a sua fronteira.
+ */
+class Isochrone {
+public:
+    Isochrone(double radius);
+
+    double getRadius() const;
+
+    const vector<Vertex<Node>*> & getNodes() const;
+
+    void addNode(Vertex<Node>* node);
+
+    const vector<Vertex<Node>*> & getFrontier() const;
+
+    void addFrontier(Vertex<Node>* node);
+
+    const vector<BoundarySegment> & getBoundary() const;
+
+    void addSegment(const BoundarySegment & segment);
+
+private:
+    double radius;
+    vector<Vertex<Node>*> nodes;        // nodes within the radius, by increasing distance
+    vector<Vertex<Node>*> frontier;     // nodes within the radius with a road leaving the isochrone
+    vector<BoundarySegment> boundary;   // contour obtained by marching squares over a grid of cells
+};
+
+/**
+ * Função que calcula isócronas de vários raios à volta de um node, com uma única pesquisa limitada ao maior raio.
+ * Como a pesquisa devolve os nodes por distância crescente, cada isócrona é um prefixo dessa lista.
+ * O contorno é obtido por marching squares sobre uma grelha onde cada célula guarda a menor distância
+ * dos nodes que lhe pertencem, grelha essa que é preenchida uma única vez para todos os raios.
+ *
+ * @param graph grafo a processar
+ * @param centre node central (garagem ou fábrica)
+ * @param radii raios pretendidos, em metros (ou em segundos se forem dados perfis)
+ * @param cellSize lado das células da grelha em metros (0 para escolher automaticamente)
+ * @param profiles perfis de tempo de viagem, nullptr para usar distâncias
+ * @param departure hora de partida do node central (segundos desde a meia-noite)
+ *
+ * @return Vetor com uma isócrona por raio, por ordem crescente de raio.
+ */
+vector<Isochrone> computeIsochrones(Graph<Node> &graph, Vertex<Node>* centre, vector<double> radii, double cellSize = 0,
+                                    const TimeProfiles *profiles = nullptr, double departure = 0);
+
+#endif //CAL_PROJ_ISOCHRONE_H
@@ -0,0 +1,155 @@
+//
+// LegCache.cpp
+//
+
+#include "LegCache.h"
+
+LegKey::LegKey(const string &city, uint64_t graph, int src, int dst, unsigned weights)
+        : graph(graph), src(src), dst(dst), weights(weights) {
+    // FNV-1a, so the key does not depend on the standard library's string hash
+    uint64_t h = 14695981039346656037ULL;
+    for (unsigned char c : city) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    this->city = h;
+}
+
+bool LegKey::operator==(const LegKey &other) const {
+    return city == other.city && graph == other.graph && src == other.src && dst == other.dst && weights == other.weights;
+}
+
+size_t LegKeyHash::operator()(const LegKey &key) const {
+    uint64_t h = key.city;
+    h = (h ^ key.graph) * 0x9E3779B97F4A7C15ULL;
+    h = (h ^ (uint32_t) key.src) * 0x9E3779B97F4A7C15ULL;
+    h = (h ^ (uint32_t) key.dst) * 0x9E3779B97F4A7C15ULL;
+    h = (h ^ key.weights) * 0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 32);
+}
+
+LegCache::Entry::Entry(const LegKey &key) : key(key) {}
+
+LegCache::LegCache(size_t budget) : budget(budget) {}
+
+LegCache::Shard &LegCache::shardOf(const LegKey &key) {
+    // the low bits pick the bucket inside the shard's map, use the high ones for the shard
+    return shards[(LegKeyHash()(key) >> 40) % LEG_CACHE_SHARDS];
+}
+
+bool LegCache::lookup(const LegKey &key, double &cost, vector<int> &path) {
+    Shard &shard = shardOf(key);
+    shared_lock<shared_timed_mutex> guard(shard.lock);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        misses++;
+        return false;
+    }
+    Entry &entry = shard.entries[it->second];
+    entry.referenced.store(true, memory_order_relaxed);
+    cost = entry.cost;
+    path = entry.path;
+    hits++;
+    return true;
+}
+
+void LegCache::insert(const LegKey &key, double cost, const vector<int> &path) {
+    Shard &shard = shardOf(key);
+    size_t bytes = sizeof(Entry) + path.size() * sizeof(int) + 2 * sizeof(void *) + sizeof(LegKey);   // entry, path and map node
+    size_t shardBudget = budget / LEG_CACHE_SHARDS;
+    if (bytes > shardBudget)
+        return;
+    unique_lock<shared_timed_mutex> guard(shard.lock);
+
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        Entry &entry = shard.entries[it->second];
+        shard.bytes -= entry.bytes;
+        entry.cost = cost;
+        entry.path = path;
+        entry.bytes = bytes;
+        shard.bytes += bytes;
+        return;
+    }
+
+    // CLOCK: give marked entries a second chance, evict the first unmarked one, until the new entry fits
+    while (shard.bytes + bytes > shardBudget) {
+        if (shard.hand >= shard.entries.size())
+            shard.hand = 0;
+        Entry &entry = shard.entries[shard.hand];
+        if (entry.used) {
+            if (entry.referenced.load(memory_order_relaxed))
+                entry.referenced.store(false, memory_order_relaxed);
+            else {
+                shard.index.erase(entry.key);
+                shard.bytes -= entry.bytes;
+                entry.used = false;
+                vector<int>().swap(entry.path);
+                shard.freeSlots.push_back(shard.hand);
+                evictions++;
+            }
+        }
+        shard.hand++;
+    }
+
+    unsigned slot;
+    if (!shard.freeSlots.empty()) {
+        slot = shard.freeSlots.back();
+        shard.freeSlots.pop_back();
+        shard.entries[slot].key = key;
+    }
+    else {
+        slot = shard.entries.size();
+        shard.entries.emplace_back(key);
+    }
+    Entry &entry = shard.entries[slot];
+    entry.cost = cost;
+    entry.path = path;
+    entry.bytes = bytes;
+    entry.used = true;
+    entry.referenced.store(false, memory_order_relaxed);
+    shard.index[key] = slot;
+    shard.bytes += bytes;
+}
+
+void LegCache::clear() {
+    for (auto & shard : shards) {
+        unique_lock<shared_timed_mutex> guard(shard.lock);
+        shard.entries.clear();
+        shard.freeSlots.clear();
+        shard.index.clear();
+        shard.bytes = 0;
+        shard.hand = 0;
+    }
+    hits = misses = evictions = 0;
+}
+
+unsigned long long LegCache::getHits() const {
+    return hits;
+}
+
+unsigned long long LegCache::getMisses() const {
+    return misses;
+}
+
+unsigned long long LegCache::getEvictions() const {
+    return evictions;
+}
+
+size_t LegCache::getEntries() const {
+    size_t n = 0;
+    for (auto & shard : shards) {
+        shared_lock<shared_timed_mutex> guard(shard.lock);
+        n += shard.index.size();
+    }
+    return n;
+}
+
+size_t LegCache::getBytes() const {
+    size_t n = 0;
+    for (auto & shard : shards) {
+        shared_lock<shared_timed_mutex> guard(shard.lock);
+        n += shard.bytes;
+    }
+    return n;
+}
@@ -0,0 +1,116 @@
+//
+// LegCache.h
+//
+
+#ifndef CAL_PROJ_LEGCACHE_H
+#define CAL_PROJ_LEGCACHE_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <cstdint>
+
+using namespace std;
+
+#define LEG_CACHE_SHARDS 16
+#define LEG_CACHE_BUDGET (64 << 20)     // bytes
+
+#define WEIGHTS_DISTANCE 0      // edge weights are the road lengths (Dijkstra, Bellman-Ford, ...)
+
+/**
+ * Chave de uma perna em cache: cidade, versão do grafo, nodes de partida e chegada e conjunto de pesos usado na
+ * pesquisa. A versão distingue os grafos da mesma cidade com mais ou menos nodes carregados (modo por regiões),
+ * onde o caminho mais curto entre os mesmos nodes pode ser outro.
+ */
+struct LegKey {
+    uint64_t city;      // hash of the city name
+    uint64_t graph;     // number of vertices << 32 | number of roads of the graph searched
+    int src;            // node ids
+    int dst;
+    unsigned weights;   // WEIGHTS_...
+
+    LegKey(const string &city, uint64_t graph, int src, int dst, unsigned weights);
+
+    bool operator==(const LegKey &other) const;
+};
+
+struct LegKeyHash {
+    size_t operator()(const LegKey &key) const;
+};
+
+/**
+ * Cache em memória de pernas já calculadas (custo e sequência de nodes), para não repetir as mesmas
+ * pesquisas quando vários serviços usam as mesmas pernas (garagem -> X, X -> fábrica).
+ *
+ * As entradas estão divididas por LEG_CACHE_SHARDS partes, cada uma com o seu lock, escolhida pelo hash da
+ * chave. As procuras só precisam do lock partilhado, pelo que várias threads procuram ao mesmo tempo sem se
+ * bloquearem: a política de substituição é CLOCK, e uma procura bem sucedida só marca a entrada como usada
+ * (um bit atómico), em vez de a mover numa lista como no LRU. Só as inserções precisam do lock exclusivo da
+ * sua parte. Quando o limite de memória é atingido, o ponteiro do relógio percorre as entradas, dando uma
+ * segunda oportunidade às marcadas e removendo a primeira que não esteja marcada.
+ */
+class LegCache {
+public:
+    /**
+     * @param budget limite de memória ocupada pelas entradas, em bytes
+     */
+    explicit LegCache(size_t budget = LEG_CACHE_BUDGET);
+
+    /**
+     * @param cost recebe o custo da perna
+     * @param path recebe os ids dos nodes da perna, do de partida ao de chegada
+     *
+     * @return true se a perna estiver em cache.
+     */
+    bool lookup(const LegKey &key, double &cost, vector<int> &path);
+
+    /**
+     * Guarda uma perna, substituindo a que tiver a mesma chave.
+     */
+    void insert(const LegKey &key, double cost, const vector<int> &path);
+
+    void clear();
+
+    unsigned long long getHits() const;
+
+    unsigned long long getMisses() const;
+
+    unsigned long long getEvictions() const;
+
+    size_t getEntries() const;
+
+    size_t getBytes() const;
+
+private:
+    struct Entry {
+        LegKey key;
+        double cost = 0;
+        vector<int> path;
+        size_t bytes = 0;
+        bool used = false;                  // false for a free slot
+        atomic<bool> referenced{false};     // CLOCK bit, set by lookups
+
+        explicit Entry(const LegKey &key);
+    };
+
+    struct Shard {
+        mutable shared_timed_mutex lock;
+        deque<Entry> entries;               // a deque never moves its elements
+        vector<unsigned> freeSlots;
+        unordered_map<LegKey, unsigned, LegKeyHash> index;
+        size_t bytes = 0;
+        unsigned hand = 0;                  // CLOCK hand
+    };
+
+    Shard &shardOf(const LegKey &key);
+
+    size_t budget;
+    Shard shards[LEG_CACHE_SHARDS];
+    atomic<unsigned long long> hits{0}, misses{0}, evictions{0};
+};
+
+#endif //CAL_PROJ_LEGCACHE_H
@@ -16,14 +16,17 @@ int mainMenu(){
         cout << "[2] Display accesible nodes from the garage" << endl;
         cout << "[3] Explain how to generate a service and list accesible nodes from the garage (in case you need help)" << endl;
         cout << "[4] Load a service and display optimal path solution" << endl;
-        cout << "[5] Exit program" << endl;
+        cout << "[5] Show alternative routes between two nodes" << endl;
+        cout << "[6] Show isochrones around the garage or a factory" << endl;
+        cout << "[7] Compare the speed of the shortest path kernels" << endl;
+        cout << "[8] Exit program" << endl;
         cin >> i;
         cout << endl << endl;
 
-        if(i > 5)
+        if(i > 8)
             cout << "Invalid option. Please try again." << endl << endl;
 
-    } while(i > 5);
+    } while(i > 8);
 
     return i;
 }
@@ -94,6 +97,84 @@ int chooseCity(string& city){
 
 }
 
+int chooseLoadMode(){
+    unsigned int i;
+
+    do {
+        cout << "How should the map be loaded?" << endl;
+        cout << "[0] Whole map" << endl;
+        cout << "[1] Only the region around each service (faster for big maps like Lisboa)" << endl;
+
+        cin >> i;
+        cout << endl;
+
+        if(i > 1)
+            cout << "Invalid option!" << endl;
+
+    } while(i > 1);
+
+    return i;
+}
+
+int chooseRoutingMode(){
+    unsigned int i;
+
+    do {
+        cout << "How should the routes be calculated?" << endl;
+        cout << "[0] Choose an algorithm and wait for the final route" << endl;
+        cout << "[1] Anytime: show a quick route at once and refresh it while it improves" << endl;
+        cout << "[2] Clusters: split the pickup points among several vehicles and route them in parallel" << endl;
+
+        cin >> i;
+        cout << endl;
+
+        if(i > 2)
+            cout << "Invalid option!" << endl;
+
+    } while(i > 2);
+
+    return i;
+}
+
+void chooseRoutingOptions(RoutingContext &context){
+    unsigned int n;
+
+    do {
+        cout << "What algorithm should be used?" << endl;
+        cout << "0 -> Dijkstra's Shortest Path" << endl;
+        cout << "1 -> Bellman-Ford's algorithm" << endl;
+        cout << "2 -> Time-dependent A* (takes rush hour into account)" << endl;
+        cout << "3 -> Turn-aware Dijkstra (avoids U-turns and sharp turns)" << endl;
+        cout << "4 -> Dijkstra with a contraction hierarchy distance table (recommended for big services)" << endl;
+        cout << "5 -> Dijkstra restricted to a corridor around each leg (faster on big maps)" << endl;
+        cout << "6 -> Dijkstra with a batched distance table (faster on small and medium maps)" << endl;
+        cout << "Tip: if there are edges with negative weight, Bellman-Ford's algorithm is recommended." << endl;
+        cout << "Option: ";
+        cin >> n;
+
+        if (n > 6)
+            cout << endl << endl << "Invalid option! Try again." << endl << endl;
+
+    } while (n > 6);
+    context.algoritmo = n;
+
+    context.departure = 0;
+    if (n == 2) {
+        cout << "Departure time from the garage, in hours (i.e. 8.5 for 08:30): ";
+        cin >> context.departure;
+        context.departure *= 3600;
+    }
+
+    context.timeLimit = chooseTimeLimit();
+}
+
+double chooseTimeLimit(){
+    double limit;
+    cout << "Time limit in seconds (0 for no limit): ";
+    cin >> limit;
+    return limit;
+}
+
 void help(vector<Vertex<Node>*> accessible){
     cout<<"Here all accessible nodes:"<<endl<<endl;
     for(auto i : accessible){
@@ -8,6 +8,7 @@
 #include <string>
 #include "Node.h"
 #include "Graph.h"
+#include "GraphFuncs.h"
 
 using namespace std;
 
@@ -27,6 +28,36 @@ int mainMenu();
  */
 int chooseCity(string& city);
 
+/**
+ * Menu que pergunta se deve ser carregado o mapa inteiro ou apenas a região à volta de cada serviço
+ *
+ * @return 0 para o mapa inteiro, 1 para carregar por regiões
+ */
+int chooseLoadMode();
+
+/**
+ * Menu que pergunta se a rota de um serviço deve ser calculada de uma só vez, no modo anytime ou por grupos
+ *
+ * @return 0 para escolher um algoritmo e esperar pela rota, 1 para o modo anytime, 2 para dividir os pontos de
+ * recolha por vários veiculos (clusterService)
+ */
+int chooseRoutingMode();
+
+/**
+ * Menu que pergunta o algoritmo com que orderEdges calcula a rota, a hora de partida (só para o algoritmo
+ * dependente do tempo) e o limite de tempo
+ *
+ * @param context opções a preencher; as estruturas auxiliares não são alteradas
+ */
+void chooseRoutingOptions(RoutingContext &context);
+
+/**
+ * Pergunta o limite de tempo do cálculo de uma rota
+ *
+ * @return limite em segundos, 0 para não ter limite
+ */
+double chooseTimeLimit();
+
 /**
  * Menu que apresenta o id de todos os nodes accessiveis a partir da garagem
  *
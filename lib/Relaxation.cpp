@@ -0,0 +1,111 @@
+//
+// Relaxation.cpp
+//
+
+#include <limits>
+#include "Relaxation.h"
+
+#ifdef RELAX_AVX2
+#include <immintrin.h>
+#endif
+
+unsigned relaxScalar(const unsigned *targets, const double *weights, unsigned count, double d, double *dist, unsigned *improved) {
+    unsigned n = 0;
+    for (unsigned i = 0; i < count; i++) {
+        double candidate = d + weights[i];
+        if (candidate < dist[targets[i]]) {
+            dist[targets[i]] = candidate;
+            improved[n++] = i;
+        }
+    }
+    return n;
+}
+
+#ifdef RELAX_AVX2
+__attribute__((target("avx2")))
+unsigned relaxAvx2(const unsigned *targets, const double *weights, unsigned count, double d, double *dist, unsigned *improved) {
+    unsigned n = 0, i = 0;
+    __m256d base = _mm256_set1_pd(d);
+    for (; i + 4 <= count; i += 4) {
+        __m128i index = _mm_loadu_si128((const __m128i *) (targets + i));
+        __m256d old = _mm256_i32gather_pd(dist, index, 8);
+        __m256d candidate = _mm256_add_pd(base, _mm256_loadu_pd(weights + i));
+        int mask = _mm256_movemask_pd(_mm256_cmp_pd(candidate, old, _CMP_LT_OQ));
+        if (mask == 0)
+            continue;
+        double lanes[4];
+        _mm256_storeu_pd(lanes, candidate);
+        while (mask != 0) {
+            int k = __builtin_ctz(mask);
+            mask &= mask - 1;
+            // parallel edges put the same target in two lanes, so compare again with what the other lane stored
+            if (lanes[k] < dist[targets[i + k]]) {
+                dist[targets[i + k]] = lanes[k];
+                improved[n++] = i + k;
+            }
+        }
+    }
+    for (; i < count; i++) {
+        double candidate = d + weights[i];
+        if (candidate < dist[targets[i]]) {
+            dist[targets[i]] = candidate;
+            improved[n++] = i;
+        }
+    }
+    return n;
+}
+#endif
+
+double relaxLanesScalar(const double *from, double w, double *to) {
+    double best = std::numeric_limits<double>::max();
+    for (unsigned l = 0; l < BATCH_LANES; l++) {
+        double candidate = from[l] + w;
+        if (candidate < to[l]) {
+            to[l] = candidate;
+            if (candidate < best)
+                best = candidate;
+        }
+    }
+    return best;
+}
+
+#ifdef RELAX_AVX2
+__attribute__((target("avx2")))
+double relaxLanesAvx2(const double *from, double w, double *to) {
+    __m256d candidate = _mm256_add_pd(_mm256_loadu_pd(from), _mm256_set1_pd(w));
+    __m256d old = _mm256_loadu_pd(to);
+    __m256d better = _mm256_cmp_pd(candidate, old, _CMP_LT_OQ);
+    if (_mm256_movemask_pd(better) == 0)
+        return std::numeric_limits<double>::max();
+    _mm256_storeu_pd(to, _mm256_min_pd(candidate, old));
+    // smallest improved lane, the others count as INF
+    __m256d improved = _mm256_blendv_pd(_mm256_set1_pd(std::numeric_limits<double>::max()), candidate, better);
+    __m128d half = _mm_min_pd(_mm256_castpd256_pd128(improved), _mm256_extractf128_pd(improved, 1));
+    return _mm_cvtsd_f64(_mm_min_sd(half, _mm_unpackhi_pd(half, half)));
+}
+#endif
+
+bool hasAvx2() {
+#ifdef RELAX_AVX2
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+RelaxKernel getRelaxKernel(bool vectorised) {
+#ifdef RELAX_AVX2
+    if (vectorised && hasAvx2())
+        return relaxAvx2;
+#endif
+    return relaxScalar;
+}
+
+LaneKernel getLaneKernel(bool vectorised) {
+#ifdef RELAX_AVX2
+    if (vectorised && hasAvx2())
+        return relaxLanesAvx2;
+#endif
+    return relaxLanesScalar;
+}
@@ -0,0 +1,81 @@
+//
+// Relaxation.h
+//
+
+#ifndef CAL_PROJ_RELAXATION_H
+#define CAL_PROJ_RELAXATION_H
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define RELAX_AVX2     // the compiler can build the AVX2 kernel, the CPU is checked at runtime
+#endif
+
+#define BATCH_LANES 4   // searches run together by a batched search, one AVX2 register of doubles
+
+/**
+ * Relaxa um bloco de arestas consecutivas de um StaticGraph a partir de um vertex à distância d:
+ * para cada aresta i, se d + weights[i] for menor do que dist[targets[i]], atualiza a distância.
+ *
+ * @param targets vertices de chegada das arestas
+ * @param weights pesos das arestas
+ * @param count número de arestas
+ * @param d distância do vertex de onde saem as arestas
+ * @param dist distâncias de todos os vertices
+ * @param improved recebe, por ordem, o índice (entre 0 e count) das arestas que melhoraram uma distância
+ *
+ * @return número de arestas escritas em improved.
+ */
+typedef unsigned (*RelaxKernel)(const unsigned *targets, const double *weights, unsigned count, double d,
+                                double *dist, unsigned *improved);
+
+/**
+ * Versão escalar, uma aresta de cada vez.
+ */
+unsigned relaxScalar(const unsigned *targets, const double *weights, unsigned count, double d, double *dist, unsigned *improved);
+
+#ifdef RELAX_AVX2
+/**
+ * Versão AVX2, quatro arestas de cada vez: as distâncias dos destinos são lidas com um gather e comparadas
+ * de uma só vez, e só as que melhoram são escritas (AVX2 não tem scatter).
+ * Só pode ser chamada se hasAvx2() devolver true.
+ */
+unsigned relaxAvx2(const unsigned *targets, const double *weights, unsigned count, double d, double *dist, unsigned *improved);
+#endif
+
+/**
+ * Relaxa uma aresta de peso w para BATCH_LANES pesquisas ao mesmo tempo: cada distância to[l] passa a
+ * min(to[l], from[l] + w).
+ *
+ * @param from distâncias, em cada pesquisa, do vertex de onde sai a aresta
+ * @param w peso da aresta
+ * @param to distâncias, em cada pesquisa, do vertex onde chega a aresta
+ *
+ * @return menor das distâncias melhoradas, INF se nenhuma melhorou.
+ */
+typedef double (*LaneKernel)(const double *from, double w, double *to);
+
+double relaxLanesScalar(const double *from, double w, double *to);
+
+#ifdef RELAX_AVX2
+double relaxLanesAvx2(const double *from, double w, double *to);
+#endif
+
+/**
+ * @return true se o processador (e o sistema operativo) suportarem AVX2.
+ */
+bool hasAvx2();
+
+/**
+ * Escolhe o kernel de relaxação a usar, de acordo com o processador.
+ *
+ * @param vectorised false para forçar a versão escalar
+ */
+RelaxKernel getRelaxKernel(bool vectorised = true);
+
+/**
+ * Escolhe o kernel de relaxação das pesquisas em lote, de acordo com o processador.
+ *
+ * @param vectorised false para forçar a versão escalar
+ */
+LaneKernel getLaneKernel(bool vectorised = true);
+
+#endif //CAL_PROJ_RELAXATION_H
@@ -0,0 +1,148 @@
+//
+// Route.cpp
+//
+
+#include <cstring>
+#include "Route.h"
+
+Route::Route() {}
+
+Route::Route(const vector<uint32_t> &vertices, const vector<uint32_t> &legStart, const vector<float> &legCost) {
+    if (vertices.empty() || legStart.size() < 2 || legCost.size() != legStart.size())
+        return;
+    unsigned nLegs = legStart.size() - 1;
+    data.resize(2 + vertices.size() + 2 * (nLegs + 1));
+    data[0] = vertices.size();
+    data[1] = nLegs;
+    memcpy(&data[2], vertices.data(), vertices.size() * sizeof(uint32_t));
+    memcpy(&data[2 + vertices.size()], legStart.data(), legStart.size() * sizeof(uint32_t));
+    memcpy(&data[2 + vertices.size() + legStart.size()], legCost.data(), legCost.size() * sizeof(float));
+}
+
+bool Route::empty() const {
+    return data.empty();
+}
+
+unsigned Route::getNumVertices() const {
+    return data.empty() ? 0 : data[0];
+}
+
+uint32_t Route::getVertex(unsigned i) const {
+    return data[2 + i];
+}
+
+unsigned Route::getNumLegs() const {
+    return data.empty() ? 0 : data[1];
+}
+
+const uint32_t *Route::legData() const {
+    return &data[2 + data[0]];
+}
+
+unsigned Route::getLegBegin(unsigned l) const {
+    return legData()[l];
+}
+
+unsigned Route::getLegEnd(unsigned l) const {
+    return legData()[l + 1];
+}
+
+double Route::getLegCost(unsigned l) const {
+    float begin, end;
+    memcpy(&begin, legData() + getNumLegs() + 1 + l, sizeof(float));
+    memcpy(&end, legData() + getNumLegs() + 2 + l, sizeof(float));
+    return end - begin;
+}
+
+double Route::getTotalCost() const {
+    if (data.empty())
+        return 0;
+    float total;
+    memcpy(&total, legData() + 2 * getNumLegs() + 1, sizeof(float));
+    return total;
+}
+
+bool Route::isComplete() const {
+    return complete;
+}
+
+void Route::setComplete(bool complete) {
+    this->complete = complete;
+}
+
+size_t Route::getMemory() const {
+    return sizeof(Route) + data.capacity() * sizeof(uint32_t);
+}
+
+static void putVarint(vector<uint8_t> &bytes, uint32_t value) {
+    while (value >= 0x80) {
+        bytes.push_back((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    bytes.push_back(value);
+}
+
+static bool getVarint(const vector<uint8_t> &bytes, size_t &pos, uint32_t &value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 35; shift += 7) {
+        if (pos >= bytes.size())
+            return false;
+        uint8_t b = bytes[pos++];
+        value |= (uint32_t) (b & 0x7F) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+vector<uint8_t> Route::encode() const {
+    vector<uint8_t> bytes;
+    unsigned n = getNumVertices(), nLegs = getNumLegs();
+    putVarint(bytes, n);
+    putVarint(bytes, nLegs);
+    uint32_t previous = 0;
+    for (unsigned i = 0; i < n; i++) {
+        int32_t delta = (int32_t) (getVertex(i) - previous);
+        putVarint(bytes, ((uint32_t) delta << 1) ^ (uint32_t) (delta >> 31));    // zigzag
+        previous = getVertex(i);
+    }
+    for (unsigned l = 0; l <= nLegs && n > 0; l++)
+        putVarint(bytes, l == 0 ? legData()[0] : legData()[l] - legData()[l - 1]);
+    for (unsigned l = 0; l <= nLegs && n > 0; l++) {
+        uint32_t bits = legData()[nLegs + 1 + l];
+        for (unsigned b = 0; b < 4; b++)
+            bytes.push_back((bits >> (8 * b)) & 0xFF);
+    }
+    return bytes;
+}
+
+Route Route::decode(const vector<uint8_t> &bytes) {
+    size_t pos = 0;
+    uint32_t n, nLegs, value;
+    if (!getVarint(bytes, pos, n) || !getVarint(bytes, pos, nLegs) || n == 0)
+        return Route();
+
+    vector<uint32_t> vertices(n), legStart(nLegs + 1);
+    vector<float> legCost(nLegs + 1);
+    uint32_t previous = 0;
+    for (unsigned i = 0; i < n; i++) {
+        if (!getVarint(bytes, pos, value))
+            return Route();
+        previous += (value >> 1) ^ -(value & 1);
+        vertices[i] = previous;
+    }
+    for (unsigned l = 0; l <= nLegs; l++) {
+        if (!getVarint(bytes, pos, value))
+            return Route();
+        legStart[l] = l == 0 ? value : legStart[l - 1] + value;
+    }
+    for (unsigned l = 0; l <= nLegs; l++) {
+        if (pos + 4 > bytes.size())
+            return Route();
+        uint32_t bits = 0;
+        for (unsigned b = 0; b < 4; b++)
+            bits |= (uint32_t) bytes[pos++] << (8 * b);
+        memcpy(&legCost[l], &bits, sizeof(float));
+    }
+    return Route(vertices, legStart, legCost);
+}
@@ -0,0 +1,84 @@
+//
+// Route.h
+//
+
+#ifndef CAL_PROJ_ROUTE_H
+#define CAL_PROJ_ROUTE_H
+
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+/**
+ * Rota de um veiculo guardada de forma compacta: a sequência de vertices percorridos (índices de 32 bits
+ * no vertexSet do grafo), o início de cada perna (garagem -> recolha -> ... -> fábrica) e o custo acumulado
+ * no fim de cada perna.
+ *
+ * Tudo é guardado num único vetor de 32 bits, pelo que copiar uma rota é uma única cópia de memória.
+ * Layout: [nVertices, nLegs, vertices[nVertices], legStart[nLegs + 1], legCost[nLegs + 1] (floats)].
+ */
+class Route {
+public:
+    Route();
+
+    /**
+     * @param vertices vertices percorridos
+     * @param legStart indice em vertices do inicio de cada perna, mais um último elemento igual ao indice
+     * do último vertice (as pernas partilham o vertice onde se juntam)
+     * @param legCost custo acumulado no inicio de cada perna, mais o custo total
+     */
+    Route(const vector<uint32_t> &vertices, const vector<uint32_t> &legStart, const vector<float> &legCost);
+
+    bool empty() const;
+
+    unsigned getNumVertices() const;
+
+    uint32_t getVertex(unsigned i) const;
+
+    unsigned getNumLegs() const;
+
+    /**
+     * A perna l vai do vertice getLegBegin(l) ao vertice getLegEnd(l), inclusive.
+     */
+    unsigned getLegBegin(unsigned l) const;
+
+    unsigned getLegEnd(unsigned l) const;
+
+    double getLegCost(unsigned l) const;
+
+    double getTotalCost() const;
+
+    /**
+     * @return false se o cálculo da rota foi interrompido: a rota tem apenas as pernas calculadas até então.
+     */
+    bool isComplete() const;
+
+    void setComplete(bool complete);
+
+    /**
+     * @return memória ocupada pela rota, em bytes.
+     */
+    size_t getMemory() const;
+
+    /**
+     * Codifica a rota para armazenamento: diferenças entre vertices consecutivos e comprimentos das pernas
+     * em varints (zigzag para as diferenças), custos em bytes.
+     */
+    vector<uint8_t> encode() const;
+
+    /**
+     * Operação inversa de encode.
+     *
+     * @return rota descodificada, vazia se os dados estiverem corrompidos.
+     */
+    static Route decode(const vector<uint8_t> &bytes);
+
+private:
+    const uint32_t *legData() const;
+
+    vector<uint32_t> data;
+    bool complete = true;
+};
+
+#endif //CAL_PROJ_ROUTE_H
@@ -2,6 +2,7 @@
 // Created by Nunation on 13/05/2020.
 //
 
+#include <algorithm>
 #include "Service.h"
 
 int Service::getId() const {
@@ -50,3 +51,34 @@ Service::Service(int id, Vertex<Node> *garagem, Vertex<Node> *destino) : id(id),
 Service::Service(int id, Vertex<Node> *garagem, Vertex<Node> *destino, const vector<Vertex<Node>*> & pontosRecolha) : id(
         id), garagem(garagem), destino(destino), pontosRecolha(pontosRecolha) {}
 
+const string &Service::getCity() const {
+    return city;
+}
+
+void Service::setCity(const string &city) {
+    Service::city = city;
+}
+
+uint64_t Service::fingerprint() const {
+    vector<int> ids;
+    for (auto p : pontosRecolha)
+        ids.push_back(p->getInfo().getId());
+    return fingerprint(city, garagem->getInfo().getId(), destino->getInfo().getId(), ids);
+}
+
+uint64_t Service::fingerprint(const string &city, int garagem, int destino, vector<int> pontosRecolha) {
+    sort(pontosRecolha.begin(), pontosRecolha.end());
+    pontosRecolha.insert(pontosRecolha.begin(), {garagem, destino});
+    // FNV-1a over the city name and then the node ids
+    uint64_t h = 14695981039346656037ULL;
+    for (unsigned char c : city) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    for (int id : pontosRecolha)
+        for (unsigned b = 0; b < sizeof(id); b++) {
+            h ^= (id >> (8 * b)) & 0xff;
+            h *= 1099511628211ULL;
+        }
+    return h;
+}
@@ -8,6 +8,7 @@
 #include "Node.h"
 #include "Graph.h"
 #include "Vehicle.h"
+#include <cstdint>
 
 class Service{
 public:
@@ -35,11 +36,27 @@ public:
 
     void setVehicle(const Vehicle &vehicle);
 
+    const string &getCity() const;
+
+    void setCity(const string &city);
+
+    /**
+     * Impressão digital do serviço: hash da cidade, da garagem, da fábrica e do conjunto dos pontos de recolha
+     * (não depende da ordem em que os pontos foram lidos). Serviços iguais têm a mesma impressão digital.
+     */
+    uint64_t fingerprint() const;
+
+    /**
+     * Impressão digital de um serviço dado pelos ids dos seus nodes (ver fingerprint()).
+     */
+    static uint64_t fingerprint(const string &city, int garagem, int destino, vector<int> pontosRecolha);
+
 private:
     int id; // ID do veículo
     Vertex<Node>* garagem; // vértice da garagem
     Vertex<Node>* destino; // vértice da empresa
     vector<Vertex<Node>*> pontosRecolha;    //vetor dos pontos de recolha
     Vehicle vehicle;    // veículo atribuido;
+    string city;        // cidade do mapa onde o serviço é feito
 };
 #endif //CAL_PROJ_SERVICE_H
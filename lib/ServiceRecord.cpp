@@ -0,0 +1,155 @@
+//
+// ServiceRecord.cpp
+//
+
+#include <fstream>
+#include <algorithm>
+#include "ServiceRecord.h"
+
+ServiceRecord::ServiceRecord() {}
+
+ServiceRecord::ServiceRecord(const Service &service, const Graph<Node> &graph)
+        : city(service.getCity()), id(service.getId()), garagem(service.getGaragem()->getInfo().getId()),
+          destino(service.getDestino()->getInfo().getId()) {
+    for (auto p : service.getPontosRecolha())
+        pontosRecolha.push_back(p->getInfo().getId());
+    const Route &route = service.getVehicle().getRoute();
+    if (route.empty() || route.getNumLegs() == 0)
+        return;
+    const vector<Vertex<Node> *> &vertexSet = graph.getVertexSet();
+    for (unsigned v = 0; v < route.getNumVertices(); v++)
+        vertices.push_back(vertexSet[route.getVertex(v)]->getInfo().getId());
+    double cost = 0;
+    legCost.push_back(0);
+    for (unsigned l = 0; l < route.getNumLegs(); l++) {
+        legStart.push_back(route.getLegBegin(l));
+        cost += route.getLegCost(l);
+        legCost.push_back(cost);
+    }
+    legStart.push_back(route.getLegEnd(route.getNumLegs() - 1));
+    complete = route.isComplete();
+}
+
+bool ServiceRecord::save(const string &file) const {
+    ofstream out(file);
+    if (!out)
+        return false;
+    out << city << endl << id << " " << garagem << " " << destino << endl << pontosRecolha.size();
+    for (auto p : pontosRecolha)
+        out << " " << p;
+    out << endl << complete << " " << vertices.size() << " " << (legStart.empty() ? 0 : legStart.size() - 1) << endl;
+    for (auto v : vertices)
+        out << v << " ";
+    out << endl;
+    for (auto s : legStart)
+        out << s << " ";
+    out << endl;
+    out.precision(9);
+    for (auto c : legCost)
+        out << c << " ";
+    out << endl;
+    return (bool) out;
+}
+
+bool ServiceRecord::load(const string &file) {
+    ifstream in(file);
+    unsigned nrPR, nrVertices, nrLegs;
+    if (!(in >> city >> id >> garagem >> destino >> nrPR))
+        return false;
+    pontosRecolha.assign(nrPR, 0);
+    for (auto &p : pontosRecolha)
+        in >> p;
+    in >> complete >> nrVertices >> nrLegs;
+    vertices.assign(nrVertices, 0);
+    for (auto &v : vertices)
+        in >> v;
+    legStart.assign(nrLegs > 0 ? nrLegs + 1 : 0, 0);
+    for (auto &s : legStart)
+        in >> s;
+    legCost.assign(nrLegs > 0 ? nrLegs + 1 : 0, 0);
+    for (auto &c : legCost)
+        in >> c;
+    return in && isConsistent();
+}
+
+bool ServiceRecord::isConsistent() const {
+    if (vertices.empty())
+        return legStart.empty() && legCost.empty();
+    if (legStart.size() < 2 || legCost.size() != legStart.size() || legStart[0] != 0 || legCost[0] != 0 ||
+        legStart.back() != vertices.size() - 1 || vertices[0] != garagem)
+        return false;
+    for (unsigned l = 1; l < legStart.size(); l++)
+        if (legStart[l] < legStart[l - 1] || legCost[l] < legCost[l - 1])
+            return false;
+    // every leg ends at a point of the service, each pickup at most as often as it is in the service
+    vector<int> points = pontosRecolha;
+    points.push_back(destino);
+    sort(points.begin(), points.end());
+    vector<bool> used(points.size(), false);
+    for (unsigned l = 1; l < legStart.size(); l++) {
+        auto it = lower_bound(points.begin(), points.end(), vertices[legStart[l]]);
+        while (it != points.end() && *it == vertices[legStart[l]] && used[it - points.begin()])
+            it++;
+        if (it == points.end() || *it != vertices[legStart[l]])
+            return false;
+        used[it - points.begin()] = true;
+    }
+    return !complete || (vertices.back() == destino && legStart.size() == pontosRecolha.size() + 2);
+}
+
+/*
+ * Vertex with the given node id, nullptr if it is not loaded.
+ */
+static Vertex<Node> *findById(const vector<Vertex<Node> *> &vertexSet, int id) {
+    auto it = lower_bound(vertexSet.begin(), vertexSet.end(), id, [](Vertex<Node> *v, int id) { return v->getInfo().getId() < id; });
+    return it == vertexSet.end() || (*it)->getInfo().getId() != id ? nullptr : *it;
+}
+
+bool ServiceRecord::toService(const vector<Vertex<Node> *> &vertexSet, Service &service) const {
+    if (!isConsistent())
+        return false;
+    Vertex<Node> *garage = findById(vertexSet, garagem), *factory = findById(vertexSet, destino);
+    if (garage == nullptr || factory == nullptr)
+        return false;
+    vector<Vertex<Node> *> pontos;
+    for (auto p : pontosRecolha) {
+        pontos.push_back(findById(vertexSet, p));
+        if (pontos.back() == nullptr)
+            return false;
+    }
+    vector<uint32_t> path;
+    for (auto v : vertices) {
+        Vertex<Node> *vertex = findById(vertexSet, v);
+        if (vertex == nullptr)
+            return false;
+        path.push_back(vertex->posAtVec);
+    }
+    service = Service(id, garage, factory, pontos);
+    service.setCity(city);
+    if (!vertices.empty()) {
+        Route route(path, legStart, legCost);
+        route.setComplete(complete);
+        service.setVehicle(Vehicle(1, route));
+    }
+    return true;
+}
+
+uint64_t ServiceRecord::fingerprint() const {
+    return Service::fingerprint(city, garagem, destino, pontosRecolha);
+}
+
+bool ServiceRecord::isSolved() const {
+    return complete && !vertices.empty();
+}
+
+const string &ServiceRecord::getCity() const {
+    return city;
+}
+
+int ServiceRecord::getGaragem() const {
+    return garagem;
+}
+
+int ServiceRecord::getDestino() const {
+    return destino;
+}
@@ -0,0 +1,92 @@
+//
+// ServiceRecord.h
+//
+
+#ifndef CAL_PROJ_SERVICERECORD_H
+#define CAL_PROJ_SERVICERECORD_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Service.h"
+
+using namespace std;
+
+/**
+ * Cópia de um serviço calculado que não depende do grafo em memória: a garagem, a fábrica, os pontos de recolha e
+ * os vertices da rota são guardados pelo id do node, e não por Vertex<Node>* ou pela posição no vertexSet. Pode
+ * por isso ser guardada num ficheiro e lida noutra execução, ou num grafo com outros nodes carregados, para servir
+ * de ponto de partida ao serviço seguinte (warmStart).
+ *
+ * Formato do ficheiro: cidade; id do serviço, garagem e fábrica; número de pontos de recolha e os seus ids;
+ * rota completa (0 ou 1), número de vertices e de pernas; ids dos vertices; início de cada perna (mais o último
+ * vertice); custo acumulado no início de cada perna (mais o custo total).
+ */
+class ServiceRecord {
+public:
+    ServiceRecord();
+
+    /**
+     * @param service serviço a guardar, com ou sem rota
+     * @param graph grafo onde a rota do serviço foi calculada
+     */
+    ServiceRecord(const Service &service, const Graph<Node> &graph);
+
+    /**
+     * @return false se não for possível escrever o ficheiro.
+     */
+    bool save(const string &file) const;
+
+    /**
+     * @return false se o ficheiro não existir, estiver incompleto ou a rota não for coerente (ver isConsistent).
+     */
+    bool load(const string &file);
+
+    /**
+     * Reconstrói o serviço e a rota do seu veiculo num grafo.
+     *
+     * @param vertexSet vertexSet do grafo, ordenado por id
+     * @param service recebe o serviço
+     *
+     * @return false se algum node do serviço ou da rota não estiver no grafo, ou se a rota não for coerente.
+     */
+    bool toService(const vector<Vertex<Node> *> &vertexSet, Service &service) const;
+
+    /**
+     * Verifica a rota guardada: as pernas começam no vertice 0, não andam para trás e acabam no último vertice, os
+     * custos acumulados não diminuem, a rota parte da garagem e cada perna acaba num ponto de recolha do serviço
+     * (cada um no máximo tantas vezes quantas está no serviço) ou na fábrica. Uma rota completa acaba na fábrica,
+     * com uma perna por ponto de recolha mais uma.
+     *
+     * @return true se não houver rota ou se a rota for coerente com o serviço.
+     */
+    bool isConsistent() const;
+
+    /**
+     * @return a mesma impressão digital que Service::fingerprint para o serviço guardado.
+     */
+    uint64_t fingerprint() const;
+
+    /**
+     * @return true se a rota guardada estiver calculada e completa.
+     */
+    bool isSolved() const;
+
+    const string &getCity() const;
+
+    int getGaragem() const;
+
+    int getDestino() const;
+
+private:
+    string city;
+    int id = 0;
+    int garagem = 0, destino = 0;       // node ids
+    vector<int> pontosRecolha;          // node ids
+    vector<int> vertices;               // node ids of the route
+    vector<uint32_t> legStart;          // as in Route
+    vector<float> legCost;
+    bool complete = false;
+};
+
+#endif //CAL_PROJ_SERVICERECORD_H
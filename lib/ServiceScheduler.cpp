@@ -0,0 +1,180 @@
+//
+// ServiceScheduler.cpp
+//
+
+#include <thread>
+#include <cmath>
+#include <algorithm>
+#include "ServiceScheduler.h"
+#include "GraphFuncs.h"
+
+ServiceJob::ServiceJob(unsigned id, const Service &service, double weight, double predictedCost)
+        : id(id), service(service), weight(weight), predictedCost(predictedCost) {}
+
+double ServiceJob::queueTime() const {
+    return chrono::duration<double, milli>(started - submitted).count();
+}
+
+double ServiceJob::executionTime() const {
+    return chrono::duration<double, milli>(finished - started).count();
+}
+
+ServiceScheduler::ServiceScheduler(const StaticGraph &graph, unsigned workers, unsigned policy)
+        : graph(&graph), numVertex(graph.getNumVertex()), numEdges(graph.getNumEdges()), policy(policy) {
+    startQueues(workers);
+}
+
+ServiceScheduler::ServiceScheduler(const GraphImage &image, unsigned workers, unsigned policy)
+        : image(&image), numVertex(image.getNumVertex()), numEdges(image.getNumEdges()), policy(policy) {
+    startQueues(workers);
+}
+
+void ServiceScheduler::startQueues(unsigned workers) {
+    if (workers == 0)
+        workers = max(1u, thread::hardware_concurrency());
+    this->workers = workers;
+    for (unsigned w = 0; w < workers; w++)
+        queues.emplace_back(new Queue());
+}
+
+double ServiceScheduler::predictCost(const Service &service) const {
+    double n = max(2u, numVertex);
+    return (service.getPontosRecolha().size() + 2) * (n + numEdges) * log2(n);
+}
+
+unsigned ServiceScheduler::submit(const Service &service, double deadline, double weight) {
+    unsigned id = jobs.size();
+    jobs.emplace_back(id, service, weight, predictCost(service));
+    ServiceJob &job = jobs.back();
+    job.submitted = chrono::steady_clock::now();
+    job.deadline = job.submitted + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(deadline));
+    return id;
+}
+
+bool ServiceScheduler::before(unsigned a, unsigned b) const {
+    const ServiceJob &x = jobs[a], &y = jobs[b];
+    if (policy == SCHEDULE_WSJF) {
+        double px = x.weight / x.predictedCost, py = y.weight / y.predictedCost;
+        if (px != py)
+            return px > py;
+        return x.deadline < y.deadline;
+    }
+    if (x.deadline != y.deadline)
+        return x.deadline < y.deadline;
+    return x.weight > y.weight;
+}
+
+bool ServiceScheduler::take(unsigned worker, unsigned &job) {
+    {
+        lock_guard<mutex> guard(queues[worker]->lock);
+        if (!queues[worker]->jobs.empty()) {
+            job = queues[worker]->jobs.front();
+            queues[worker]->jobs.pop_front();
+            return true;
+        }
+    }
+    // steal the most urgent job at the front of the other queues; the queues only shrink during a run,
+    // so when no queue has jobs left the batch is over
+    while (true) {
+        int victim = -1;
+        unsigned best = 0;
+        for (unsigned w = 0; w < workers; w++) {
+            if (w == worker)
+                continue;
+            lock_guard<mutex> guard(queues[w]->lock);
+            if (!queues[w]->jobs.empty() && (victim < 0 || before(queues[w]->jobs.front(), best))) {
+                victim = w;
+                best = queues[w]->jobs.front();
+            }
+        }
+        if (victim < 0)
+            return false;
+        lock_guard<mutex> guard(queues[victim]->lock);
+        if (!queues[victim]->jobs.empty()) {
+            job = queues[victim]->jobs.front();
+            queues[victim]->jobs.pop_front();
+            steals++;
+            return true;
+        }
+    }
+}
+
+void ServiceScheduler::work(unsigned worker) {
+    unsigned id;
+    while (take(worker, id)) {
+        ServiceJob &job = jobs[id];
+        job.worker = worker;
+        job.started = chrono::steady_clock::now();
+        if (job.started > job.deadline) {
+            job.finished = job.started;
+            job.state = JOB_CANCELLED;
+            continue;
+        }
+        CancelToken cancel(job.deadline);
+        Vehicle vehicle(1);
+        vehicle.setRoute(image != nullptr ? routeService(job.service, *image, &cancel) : routeService(job.service, *graph, &cancel));
+        job.service.setVehicle(vehicle);
+        job.finished = chrono::steady_clock::now();
+        if (!vehicle.getRoute().isComplete())
+            job.state = JOB_INTERRUPTED;
+        else
+            job.state = job.finished > job.deadline ? JOB_LATE : JOB_DONE;
+    }
+}
+
+void ServiceScheduler::run() {
+    vector<unsigned> pending;
+    for (auto &job : jobs)
+        if (job.state == JOB_PENDING)
+            pending.push_back(job.id);
+    sort(pending.begin(), pending.end(), [this](unsigned a, unsigned b) { return before(a, b); });
+    // dealt round-robin, so every queue stays sorted and gets a share of the urgent jobs
+    for (unsigned i = 0; i < pending.size(); i++)
+        queues[i % workers]->jobs.push_back(pending[i]);
+
+    steals = 0;
+    vector<thread> threads;
+    for (unsigned w = 0; w < workers; w++)
+        threads.emplace_back(&ServiceScheduler::work, this, w);
+    for (auto &t : threads)
+        t.join();
+}
+
+const vector<ServiceJob> &ServiceScheduler::getJobs() const {
+    return jobs;
+}
+
+unsigned ServiceScheduler::getSteals() const {
+    return steals;
+}
+
+const char *ServiceScheduler::stateName(unsigned state) {
+    const char *states[] = {"pending", "done", "late", "cancelled", "interrupted"};
+    return states[state];
+}
+
+void ServiceScheduler::printReport(ostream &out) const {
+    unsigned count[5] = {0, 0, 0, 0, 0};
+    double queued = 0, executed = 0;
+    for (auto &job : jobs) {
+        count[job.state]++;
+        out << "Job " << job.id << " (service " << job.service.getId() << ", garage " << job.service.getGaragem()->getInfo().getId()
+            << ", " << job.service.getPontosRecolha().size() << " pickup points): " << stateName(job.state);
+        if (job.state != JOB_PENDING) {
+            out << ", queued " << job.queueTime() << " ms, ran " << job.executionTime() << " ms on worker " << job.worker;
+            queued += job.queueTime();
+            executed += job.executionTime();
+        }
+        out << endl;
+    }
+    out << count[JOB_DONE] << " done, " << count[JOB_LATE] << " late, " << count[JOB_INTERRUPTED] << " interrupted, "
+        << count[JOB_CANCELLED] << " cancelled, " << count[JOB_PENDING] << " pending; " << steals << " stolen" << endl;
+    if (jobs.size() > count[JOB_PENDING])
+        out << "Average queueing time " << queued / (jobs.size() - count[JOB_PENDING]) << " ms, average execution time "
+            << executed / (jobs.size() - count[JOB_PENDING]) << " ms" << endl;
+    LegCache &cache = getLegCache();
+    SingleFlight &flights = getLegFlights();
+    out << "Leg cache: " << cache.getHits() << " hits, " << cache.getMisses() << " misses so far; coalesced "
+        << flights.getCoalesced() << " of " << flights.getSearches() + flights.getCoalesced() << " leg searches, "
+        << flights.getWaitTime() / 1000.0 << " ms waiting" << endl;
+}
@@ -0,0 +1,144 @@
+//
+// ServiceScheduler.h
+//
+
+#ifndef CAL_PROJ_SERVICESCHEDULER_H
+#define CAL_PROJ_SERVICESCHEDULER_H
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include "Service.h"
+#include "StaticGraph.h"
+#include "GraphImage.h"
+
+using namespace std;
+
+#define SCHEDULE_EDF 0      // earliest deadline first
+#define SCHEDULE_WSJF 1     // weighted shortest job first: highest weight / predicted cost first
+
+#define JOB_PENDING 0
+#define JOB_DONE 1
+#define JOB_LATE 2          // done, but after its deadline
+#define JOB_CANCELLED 3     // its deadline passed before a worker picked it up
+#define JOB_INTERRUPTED 4   // its deadline passed while the route was being computed, the route is partial
+
+/**
+ * Um serviço submetido ao ServiceScheduler, com a sua prioridade, prazo e tempos de espera e de execução.
+ */
+struct ServiceJob {
+    unsigned id;
+    Service service;            // recebe o veículo com a rota calculada
+    double weight;              // prioridade, para SCHEDULE_WSJF e para desempatar prazos iguais
+    double predictedCost;       // estimativa do trabalho da pesquisa (ver ServiceScheduler::predictCost)
+    unsigned state = JOB_PENDING;
+    unsigned worker = 0;        // thread que o processou
+    chrono::steady_clock::time_point submitted, deadline, started, finished;
+
+    ServiceJob(unsigned id, const Service &service, double weight, double predictedCost);
+
+    /**
+     * @return tempo passado na fila, em milissegundos.
+     */
+    double queueTime() const;
+
+    /**
+     * @return tempo de execução, em milissegundos.
+     */
+    double executionTime() const;
+};
+
+/**
+ * Processa um lote de serviços em várias threads, por ordem de prazo (SCHEDULE_EDF) ou de peso sobre custo
+ * previsto (SCHEDULE_WSJF), calculando as rotas com routeService.
+ *
+ * Cada thread tem a sua fila, ordenada pela política escolhida, e os serviços são distribuídos pelas filas
+ * alternadamente. Uma thread cuja fila fique vazia rouba o serviço mais urgente da frente das filas das
+ * outras, pelo que nenhuma fica parada enquanto houver serviços por fazer. Um serviço cujo prazo já passou
+ * quando chega a vez dele é cancelado em vez de ser calculado, e o cálculo de um serviço é interrompido quando
+ * o seu prazo passa, ficando com a parte da rota já calculada.
+ */
+class ServiceScheduler {
+public:
+    /**
+     * @param graph StaticGraph do grafo dos serviços, partilhado (só para leitura) por todas as threads
+     * @param workers número de threads, 0 para usar todos os núcleos
+     * @param policy SCHEDULE_EDF ou SCHEDULE_WSJF
+     */
+    ServiceScheduler(const StaticGraph &graph, unsigned workers = 0, unsigned policy = SCHEDULE_EDF);
+
+    /**
+     * Scheduler cujas threads pesquisam diretamente na imagem mapeada do grafo, em vez de numa cópia em memória.
+     *
+     * @param image imagem aberta do grafo dos serviços (ver imageMatchesGraph), que tem de continuar aberta
+     * enquanto o scheduler existir
+     */
+    ServiceScheduler(const GraphImage &image, unsigned workers = 0, unsigned policy = SCHEDULE_EDF);
+
+    /**
+     * @param service serviço a processar
+     * @param deadline prazo, em segundos a partir de agora
+     * @param weight prioridade do serviço
+     *
+     * @return id do trabalho (a sua posição em getJobs).
+     */
+    unsigned submit(const Service &service, double deadline, double weight = 1);
+
+    /**
+     * Processa todos os serviços submetidos e ainda por fazer, esperando que terminem.
+     */
+    void run();
+
+    const vector<ServiceJob> &getJobs() const;
+
+    /**
+     * @return número de serviços roubados da fila de outra thread na última execução.
+     */
+    unsigned getSteals() const;
+
+    /**
+     * Escreve o estado e os tempos de espera e de execução de cada serviço, e o uso da cache de pernas e dos pedidos
+     * juntados (getLegCache, getLegFlights) desde o início do programa.
+     */
+    void printReport(ostream &out) const;
+
+    /**
+     * @return nome do estado de um trabalho (JOB_...), como aparece no relatório.
+     */
+    static const char *stateName(unsigned state);
+
+    /**
+     * Custo previsto de um serviço: uma pesquisa por perna (mais a tabela de distâncias) sobre o grafo inteiro,
+     * isto é, (pontos de recolha + 2) * (V + E) * log2(V).
+     */
+    double predictCost(const Service &service) const;
+
+private:
+    struct Queue {
+        mutex lock;
+        deque<unsigned> jobs;
+    };
+
+    void startQueues(unsigned workers);
+
+    bool before(unsigned a, unsigned b) const;
+
+    bool take(unsigned worker, unsigned &job);
+
+    void work(unsigned worker);
+
+    const StaticGraph *graph = nullptr;     // the searches use one of the two
+    const GraphImage *image = nullptr;
+    unsigned numVertex, numEdges;
+    unsigned workers;
+    unsigned policy;
+    vector<ServiceJob> jobs;
+    vector<unique_ptr<Queue>> queues;
+    atomic<unsigned> steals{0};
+};
+
+#endif //CAL_PROJ_SERVICESCHEDULER_H
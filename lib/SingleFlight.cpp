@@ -0,0 +1,80 @@
+//
+// SingleFlight.cpp
+//
+
+#include <chrono>
+#include "SingleFlight.h"
+
+bool SingleFlight::run(const LegKey &key, const function<double(vector<int> &)> &search, double &cost, vector<int> &path) {
+    shared_ptr<Call> call;
+    bool leader = false;
+    {
+        lock_guard<mutex> guard(lock);
+        auto it = inFlight.find(key);
+        if (it == inFlight.end()) {
+            call = make_shared<Call>();
+            inFlight[key] = call;
+            leader = true;
+        }
+        else
+            call = it->second;
+    }
+
+    if (!leader) {
+        auto start = chrono::steady_clock::now();
+        unique_lock<mutex> guard(call->lock);
+        call->finished.wait(guard, [&call] { return call->done; });
+        waitTime += chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+        coalesced++;
+        if (call->error)
+            rethrow_exception(call->error);
+        cost = call->cost;
+        path = call->path;
+        return true;
+    }
+
+    searches++;
+    vector<int> result;
+    double resultCost = 0;
+    exception_ptr error;
+    try {
+        resultCost = search(result);
+    }
+    catch (...) {
+        error = current_exception();
+    }
+    {
+        // requests arriving from now on find the leg in the cache (or search it again if it was not cacheable)
+        lock_guard<mutex> guard(lock);
+        inFlight.erase(key);
+    }
+    {
+        lock_guard<mutex> guard(call->lock);
+        call->cost = resultCost;
+        call->path = result;
+        call->error = error;
+        call->done = true;
+    }
+    call->finished.notify_all();
+    if (error)
+        rethrow_exception(error);
+    cost = resultCost;
+    path.swap(result);
+    return false;
+}
+
+unsigned long long SingleFlight::getSearches() const {
+    return searches;
+}
+
+unsigned long long SingleFlight::getCoalesced() const {
+    return coalesced;
+}
+
+unsigned long long SingleFlight::getWaitTime() const {
+    return waitTime;
+}
+
+void SingleFlight::resetStats() {
+    searches = coalesced = waitTime = 0;
+}
@@ -0,0 +1,73 @@
+//
+// SingleFlight.h
+//
+
+#ifndef CAL_PROJ_SINGLEFLIGHT_H
+#define CAL_PROJ_SINGLEFLIGHT_H
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <exception>
+#include <unordered_map>
+#include "LegCache.h"
+
+using namespace std;
+
+/**
+ * Junta pesquisas iguais feitas ao mesmo tempo por várias threads: a primeira thread a pedir uma perna faz a
+ * pesquisa e as que pedirem a mesma perna enquanto esta decorre esperam pelo seu resultado, em vez de repetirem
+ * a mesma pesquisa. Uma perna só fica registada enquanto está a ser calculada; guardar resultados já calculados
+ * é o papel da LegCache.
+ */
+class SingleFlight {
+public:
+    /**
+     * Calcula uma perna, ou espera pelo cálculo da mesma perna já em curso noutra thread.
+     *
+     * @param key perna a calcular
+     * @param search pesquisa a fazer se nenhuma estiver em curso; recebe o vetor onde deixar os ids dos nodes
+     * da perna e devolve o seu custo
+     * @param cost recebe o custo da perna
+     * @param path recebe os ids dos nodes da perna
+     *
+     * @return true se o resultado veio de uma pesquisa feita por outra thread.
+     */
+    bool run(const LegKey &key, const function<double(vector<int> &)> &search, double &cost, vector<int> &path);
+
+    /**
+     * @return número de pesquisas feitas.
+     */
+    unsigned long long getSearches() const;
+
+    /**
+     * @return número de pedidos que esperaram pela pesquisa de outra thread.
+     */
+    unsigned long long getCoalesced() const;
+
+    /**
+     * @return tempo total passado à espera de pesquisas de outras threads, em microssegundos.
+     */
+    unsigned long long getWaitTime() const;
+
+    void resetStats();
+
+private:
+    struct Call {
+        mutex lock;
+        condition_variable finished;
+        bool done = false;
+        double cost = 0;
+        vector<int> path;
+        exception_ptr error;
+    };
+
+    mutex lock;
+    unordered_map<LegKey, shared_ptr<Call>, LegKeyHash> inFlight;
+    atomic<unsigned long long> searches{0}, coalesced{0}, waitTime{0};
+};
+
+#endif //CAL_PROJ_SINGLEFLIGHT_H
@@ -0,0 +1,286 @@
+//
+// StaticGraph.cpp
+//
+
+#include "StaticGraph.h"
+
+typedef pair<double, unsigned> QueueEntry;
+
+StaticGraph::StaticGraph() : firstEdge(1, 0) {}
+
+StaticGraph::StaticGraph(const Graph<Node> &graph) : vertices(graph.getVertexSet()) {
+    firstEdge.push_back(0);
+    for (auto v : vertices) {
+        for (auto e : v->getAdj()) {
+            targets.push_back(e.getDest()->posAtVec);
+            weights.push_back(e.getWeight());
+        }
+        firstEdge.push_back(targets.size());
+    }
+}
+
+unsigned StaticGraph::getNumVertex() const {
+    return firstEdge.size() - 1;
+}
+
+unsigned StaticGraph::getNumEdges() const {
+    return targets.size();
+}
+
+unsigned StaticGraph::edgeBegin(unsigned v) const {
+    return firstEdge[v];
+}
+
+unsigned StaticGraph::edgeEnd(unsigned v) const {
+    return firstEdge[v + 1];
+}
+
+unsigned StaticGraph::getTarget(unsigned e) const {
+    return targets[e];
+}
+
+double StaticGraph::getWeight(unsigned e) const {
+    return weights[e];
+}
+
+Vertex<Node>* StaticGraph::getVertex(unsigned v) const {
+    return vertices[v];
+}
+
+StaticGraph StaticGraph::reversed() const {
+    StaticGraph res;
+    unsigned n = getNumVertex();
+    res.vertices = vertices;
+    res.firstEdge.assign(n + 1, 0);
+    res.targets.resize(targets.size());
+    res.weights.resize(weights.size());
+
+    // counting sort of the edges by their target
+    for (auto t : targets)
+        res.firstEdge[t + 1]++;
+    for (unsigned v = 0; v < n; v++)
+        res.firstEdge[v + 1] += res.firstEdge[v];
+    vector<unsigned> next(res.firstEdge.begin(), res.firstEdge.end() - 1);
+    for (unsigned v = 0; v < n; v++) {
+        for (unsigned e = firstEdge[v]; e < firstEdge[v + 1]; e++) {
+            unsigned pos = next[targets[e]]++;
+            res.targets[pos] = v;
+            res.weights[pos] = weights[e];
+        }
+    }
+    return res;
+}
+
+unsigned long long StaticGraph::shortestPath(unsigned source, vector<double> &dist, vector<unsigned> &parent, RelaxKernel kernel, CancelToken *cancel) const {
+    unsigned n = getNumVertex();
+    dist.assign(n, INF);
+    parent.resize(n);
+    for (unsigned v = 0; v < n; v++)
+        parent[v] = v;
+    unsigned maxDegree = 0;
+    for (unsigned v = 0; v < n; v++)
+        maxDegree = max(maxDegree, firstEdge[v + 1] - firstEdge[v]);
+    vector<unsigned> improved(maxDegree);
+    unsigned long long relaxed = 0;
+    unsigned settled = 0;
+
+    priority_queue<QueueEntry, vector<QueueEntry>, greater<QueueEntry>> q;
+    dist[source] = 0;
+    q.push(make_pair(0.0, source));
+    while (!q.empty()) {
+        QueueEntry top = q.top();
+        q.pop();
+        unsigned v = top.second;
+        if (top.first > dist[v])
+            continue;   // stale entry, v was already settled with a shorter distance
+        if (shouldStop(cancel, settled))
+            break;
+        unsigned begin = firstEdge[v], count = firstEdge[v + 1] - begin;
+        unsigned k = kernel(targets.data() + begin, weights.data() + begin, count, dist[v], dist.data(), improved.data());
+        relaxed += count;
+        for (unsigned i = 0; i < k; i++) {
+            unsigned w = targets[begin + improved[i]];
+            parent[w] = v;
+            q.push(make_pair(dist[w], w));
+        }
+    }
+    return relaxed;
+}
+
+void StaticGraph::batchShortestPath(const unsigned *sources, unsigned count, vector<double> &dist, LaneKernel kernel, CancelToken *cancel) const {
+    unsigned n = getNumVertex();
+    dist.assign((size_t) n * BATCH_LANES, INF);
+    vector<double> queued(n, INF);      // smallest distance improved since the vertex was last scanned
+    unsigned scanned = 0;
+
+    priority_queue<QueueEntry, vector<QueueEntry>, greater<QueueEntry>> q;
+    for (unsigned l = 0; l < count && l < BATCH_LANES; l++) {
+        dist[(size_t) sources[l] * BATCH_LANES + l] = 0;
+        queued[sources[l]] = 0;
+    }
+    for (unsigned l = 0; l < count && l < BATCH_LANES; l++)
+        q.push(make_pair(0.0, sources[l]));
+    while (!q.empty()) {
+        QueueEntry top = q.top();
+        q.pop();
+        unsigned v = top.second;
+        if (top.first != queued[v])
+            continue;   // stale entry, v was scanned again after it was pushed
+        if (shouldStop(cancel, scanned))
+            break;
+        queued[v] = INF;
+        const double *from = &dist[(size_t) v * BATCH_LANES];
+        for (unsigned e = firstEdge[v]; e < firstEdge[v + 1]; e++) {
+            unsigned w = targets[e];
+            double improved = kernel(from, weights[e], &dist[(size_t) w * BATCH_LANES]);
+            if (improved < queued[w]) {
+                queued[w] = improved;
+                q.push(make_pair(improved, w));
+            }
+        }
+    }
+}
+
+vector<double> StaticGraph::distanceTable(const vector<unsigned> &sources, const vector<unsigned> &targets, bool batched, CancelToken *cancel) const {
+    unsigned m = targets.size();
+    vector<double> table(sources.size() * m, INF);
+    vector<double> dist;
+    if (!batched) {
+        vector<unsigned> parent;
+        for (unsigned i = 0; i < sources.size() && (cancel == nullptr || !cancel->isCancelled()); i++) {
+            shortestPath(sources[i], dist, parent, relaxScalar, cancel);
+            for (unsigned j = 0; j < m; j++)
+                table[i * m + j] = dist[targets[j]];
+        }
+        return table;
+    }
+    LaneKernel kernel = getLaneKernel();
+    for (unsigned first = 0; first < sources.size() && (cancel == nullptr || !cancel->isCancelled()); first += BATCH_LANES) {
+        unsigned count = min((unsigned) BATCH_LANES, (unsigned) sources.size() - first);
+        batchShortestPath(&sources[first], count, dist, kernel, cancel);
+        for (unsigned l = 0; l < count; l++)
+            for (unsigned j = 0; j < m; j++)
+                table[(first + l) * m + j] = dist[(size_t) targets[j] * BATCH_LANES + l];
+    }
+    return table;
+}
+
+vector<unsigned> StaticGraph::hopDistances(unsigned source, const StaticGraph *reverse) const {
+    unsigned n = getNumVertex();
+    vector<unsigned> hops(n, HOPS_INF);
+    vector<unsigned> frontier(1, source), next;
+    vector<bool> inFrontier(n, false);
+    unsigned long long unexplored = getNumEdges() - (edgeEnd(source) - edgeBegin(source));
+    bool bottomUp = false;
+    hops[source] = 0;
+
+    for (unsigned level = 1; !frontier.empty(); level++) {
+        if (reverse != nullptr) {
+            unsigned long long frontierEdges = 0;
+            for (auto v : frontier)
+                frontierEdges += edgeEnd(v) - edgeBegin(v);
+            // a small frontier would switch straight back, and every bottom-up step goes through all vertices
+            if (!bottomUp && frontierEdges > unexplored / BFS_ALPHA && frontier.size() >= n / BFS_BETA)
+                bottomUp = true;
+            else if (bottomUp && frontier.size() < n / BFS_BETA)
+                bottomUp = false;
+        }
+        next.clear();
+        if (bottomUp) {
+            for (auto v : frontier)
+                inFrontier[v] = true;
+            for (unsigned v = 0; v < n; v++) {
+                if (hops[v] != HOPS_INF)
+                    continue;
+                for (unsigned e = reverse->edgeBegin(v); e < reverse->edgeEnd(v); e++) {
+                    if (inFrontier[reverse->getTarget(e)]) {
+                        hops[v] = level;
+                        next.push_back(v);
+                        break;
+                    }
+                }
+            }
+            for (auto v : frontier)
+                inFrontier[v] = false;
+        }
+        else {
+            for (auto v : frontier) {
+                for (unsigned e = firstEdge[v]; e < firstEdge[v + 1]; e++) {
+                    unsigned w = targets[e];
+                    if (hops[w] == HOPS_INF) {
+                        hops[w] = level;
+                        next.push_back(w);
+                    }
+                }
+            }
+        }
+        for (auto v : next)
+            unexplored -= edgeEnd(v) - edgeBegin(v);
+        swap(frontier, next);
+    }
+    return hops;
+}
+
+vector<unsigned> StaticGraph::hopTable(const vector<unsigned> &sources, const vector<unsigned> &targets) const {
+    unsigned n = getNumVertex(), m = targets.size();
+    vector<unsigned> table(sources.size() * m, HOPS_INF);
+
+    // columns of the table at each vertex: [columnStart[v], columnStart[v + 1]) in columns
+    vector<unsigned> columnStart(n + 1, 0), columns(m);
+    for (auto t : targets)
+        columnStart[t + 1]++;
+    for (unsigned v = 0; v < n; v++)
+        columnStart[v + 1] += columnStart[v];
+    vector<unsigned> nextColumn(columnStart.begin(), columnStart.end() - 1);
+    for (unsigned j = 0; j < m; j++)
+        columns[nextColumn[targets[j]]++] = j;
+
+    vector<uint64_t> seen(n), visit(n), visitNext(n);
+    vector<unsigned> frontier, next;
+    for (unsigned first = 0; first < sources.size(); first += 64) {
+        unsigned count = min(64u, (unsigned) sources.size() - first);
+        fill(seen.begin(), seen.end(), 0);
+        frontier.clear();
+        for (unsigned b = 0; b < count; b++) {
+            unsigned s = sources[first + b];
+            if (visit[s] == 0)
+                frontier.push_back(s);
+            seen[s] |= (uint64_t) 1 << b;
+            visit[s] |= (uint64_t) 1 << b;
+        }
+        for (unsigned level = 0; !frontier.empty(); level++) {
+            // the searches in visit[v] reach v at this level
+            for (auto v : frontier) {
+                if (columnStart[v] == columnStart[v + 1])
+                    continue;
+                for (unsigned b = 0; b < count; b++) {
+                    if (!((visit[v] >> b) & 1))
+                        continue;
+                    for (unsigned c = columnStart[v]; c < columnStart[v + 1]; c++)
+                        table[(first + b) * m + columns[c]] = level;
+                }
+            }
+            next.clear();
+            for (auto v : frontier) {
+                for (unsigned e = firstEdge[v]; e < firstEdge[v + 1]; e++) {
+                    unsigned w = this->targets[e];     // the edge targets, not the table targets
+                    uint64_t reached = visit[v] & ~seen[w];
+                    if (reached == 0)
+                        continue;
+                    if (visitNext[w] == 0)
+                        next.push_back(w);
+                    visitNext[w] |= reached;
+                    seen[w] |= reached;
+                }
+            }
+            for (auto v : frontier)
+                visit[v] = 0;
+            for (auto w : next) {
+                visit[w] = visitNext[w];
+                visitNext[w] = 0;
+            }
+            swap(frontier, next);
+        }
+    }
+    return table;
+}
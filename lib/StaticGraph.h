@@ -0,0 +1,120 @@
+//
+// StaticGraph.h
+//
+
+#ifndef CAL_PROJ_STATICGRAPH_H
+#define CAL_PROJ_STATICGRAPH_H
+
+#include "Node.h"
+#include "Graph.h"
+#include "Relaxation.h"
+#include <climits>
+
+#define HOPS_INF UINT_MAX   // hop count of a vertex that cannot be reached
+#define BFS_ALPHA 14        // go bottom-up when the frontier has more than 1/BFS_ALPHA of the unexplored edges
+#define BFS_BETA 24         // go back top-down when the frontier has less than 1/BFS_BETA of the vertices
+
+/**
+ * Cópia só de leitura de um Graph<Node> em listas de adjacências compactas (CSR), indexada pela posição
+ * de cada vertex no vertexSet (posAtVec). Como não guarda estado de pesquisa, pode ser usada por várias
+ * threads ao mesmo tempo, cada uma com o seu próprio vetor de distâncias.
+ */
+class StaticGraph {
+public:
+    StaticGraph();
+
+    explicit StaticGraph(const Graph<Node> &graph);
+
+    unsigned getNumVertex() const;
+
+    unsigned getNumEdges() const;
+
+    /**
+     * As arestas que saem do vertex v são [edgeBegin(v), edgeEnd(v)).
+     */
+    unsigned edgeBegin(unsigned v) const;
+
+    unsigned edgeEnd(unsigned v) const;
+
+    unsigned getTarget(unsigned e) const;
+
+    double getWeight(unsigned e) const;
+
+    Vertex<Node>* getVertex(unsigned v) const;
+
+    /**
+     * @return grafo com todas as arestas invertidas, para pesquisas para trás.
+     */
+    StaticGraph reversed() const;
+
+    /**
+     * Dijkstra a partir de um vertex, com as arestas de cada vertex relaxadas de uma só vez pelo kernel dado.
+     *
+     * @param source índice do vertex de partida
+     * @param dist recebe a distância de cada vertex (INF se não for alcançável)
+     * @param parent recebe o vertex anterior no caminho mais curto de cada vertex (o próprio para source e os inalcançáveis)
+     * @param kernel kernel de relaxação (ver getRelaxKernel)
+     * @param cancel token que pode interromper a pesquisa, deixando as distâncias a meio (nullptr para correr até ao fim)
+     *
+     * @return número de arestas relaxadas.
+     */
+    unsigned long long shortestPath(unsigned source, vector<double> &dist, vector<unsigned> &parent, RelaxKernel kernel, CancelToken *cancel = nullptr) const;
+
+    /**
+     * Pesquisa a partir de até BATCH_LANES vertices ao mesmo tempo. Cada vertex guarda as distâncias de todas as
+     * pesquisas lado a lado, e cada aresta é relaxada para todas de uma só vez. A fila é partilhada e ordenada pela
+     * menor distância melhorada, pelo que um vertex pode ser percorrido mais do que uma vez (label-correcting).
+     *
+     * @param sources índices dos vertices de partida
+     * @param count número de vertices de partida, no máximo BATCH_LANES
+     * @param dist recebe as distâncias, dist[v * BATCH_LANES + l] é a distância de sources[l] a v
+     * @param kernel kernel de relaxação (ver getLaneKernel)
+     * @param cancel token que pode interromper a pesquisa (nullptr para correr até ao fim)
+     */
+    void batchShortestPath(const unsigned *sources, unsigned count, vector<double> &dist, LaneKernel kernel, CancelToken *cancel = nullptr) const;
+
+    /**
+     * Tabela de distâncias entre vários vertices, com uma pesquisa em lote por cada BATCH_LANES origens.
+     *
+     * @param sources índices das origens
+     * @param targets índices dos destinos
+     * @param batched false para fazer uma pesquisa (escalar) por origem
+     * @param cancel token que pode interromper o cálculo, deixando a tabela incompleta (nullptr para correr até ao fim)
+     *
+     * @return tabela densa sources.size() x targets.size(), por linhas (INF se não houver caminho).
+     */
+    vector<double> distanceTable(const vector<unsigned> &sources, const vector<unsigned> &targets, bool batched = true, CancelToken *cancel = nullptr) const;
+
+    /**
+     * Pesquisa em largura a partir de um vertex, que conta o número de arestas (saltos) até cada vertex.
+     * Se for dado o grafo invertido, a pesquisa otimiza a direção: quando a fronteira fica grande, em vez de
+     * percorrer as arestas que saem da fronteira, cada vertex ainda não visitado procura um vizinho de entrada
+     * na fronteira (bottom-up), voltando ao modo normal (top-down) quando a fronteira volta a ser pequena.
+     *
+     * @param source índice do vertex de partida
+     * @param reverse grafo invertido (reversed()), nullptr para usar sempre o modo top-down
+     *
+     * @return número de saltos até cada vertex, HOPS_INF se não for alcançável.
+     */
+    vector<unsigned> hopDistances(unsigned source, const StaticGraph *reverse = nullptr) const;
+
+    /**
+     * Tabela de saltos entre vários vertices por pesquisas em largura paralelas ao nível do bit: cada vertex tem
+     * uma máscara de 64 bits com as pesquisas que já o visitaram e outra com as que o têm na fronteira, pelo que
+     * uma passagem por uma aresta avança até 64 pesquisas de uma só vez.
+     *
+     * @param sources índices das origens
+     * @param targets índices dos destinos
+     *
+     * @return tabela densa sources.size() x targets.size(), por linhas (HOPS_INF se não houver caminho).
+     */
+    vector<unsigned> hopTable(const vector<unsigned> &sources, const vector<unsigned> &targets) const;
+
+private:
+    vector<unsigned> firstEdge;         // edges leaving vertex v are [firstEdge[v], firstEdge[v+1])
+    vector<unsigned> targets;
+    vector<double> weights;
+    vector<Vertex<Node>*> vertices;     // vertex index -> vertex (the graph's vertexSet)
+};
+
+#endif //CAL_PROJ_STATICGRAPH_H
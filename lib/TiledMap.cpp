@@ -0,0 +1,333 @@
+//
+// TiledMap.cpp
+//
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include "TiledMap.h"
+#include "GraphFuncs.h"
+
+/*
+ * Removes the parentheses and commas of a "(a, b, c)" line, as in the map files.
+ */
+static string stripLine(string line) {
+    size_t pos = line.find(')');
+    if (pos != string::npos)
+        line = line.substr(1, pos);
+    line.erase(remove(line.begin(), line.end(), ','), line.end());
+    line.erase(remove(line.begin(), line.end(), ')'), line.end());
+    return line;
+}
+
+struct TileRoad {
+    int id1, id2;
+    int tile;       // tile of id1
+    int otherTile;  // tile of id2
+};
+
+TiledMap::TiledMap() {}
+
+bool TiledMap::build(string city, double tileSize, uint64_t source) {
+    ifstream coordFile("../mapas/" + city + "/nodes_x_y_" + city + ".txt");
+    ifstream edgeFile("../mapas/" + city + "/edges_" + city + ".txt");
+    if (!coordFile || !edgeFile)
+        return false;
+
+    //------------------NODES AND GRID------------------
+    string line;
+    int aux;
+    coordFile >> aux;
+    getline(coordFile, line);
+    vector<Node> nodes;
+    double xMin = INF, yMin = INF, xMax = -INF, yMax = -INF;
+    while (getline(coordFile, line)) {
+        int id;
+        double x, y;
+        stringstream lineS(stripLine(line));
+        if (!(lineS >> id >> x >> y))
+            continue;
+        nodes.push_back(Node(id, x, y));
+        xMin = min(xMin, x);
+        yMin = min(yMin, y);
+        xMax = max(xMax, x);
+        yMax = max(yMax, y);
+    }
+    if (nodes.empty())
+        return false;
+    int cols = (int) floor((xMax - xMin) / tileSize) + 1;
+    int rows = (int) floor((yMax - yMin) / tileSize) + 1;
+
+    unordered_map<int, int> tileOf;
+    vector<pair<int, int>> nodeTile;
+    vector<vector<Node>> tileNodes(cols * rows);
+    for (auto & n : nodes) {
+        int tile = (int) floor((n.getXCoord() - xMin) / tileSize) + cols * (int) floor((n.getYCoord() - yMin) / tileSize);
+        tileOf[n.getId()] = tile;
+        nodeTile.push_back(make_pair(n.getId(), tile));
+        tileNodes[tile].push_back(n);
+    }
+    sort(nodeTile.begin(), nodeTile.end());
+
+    //------------------ROADS------------------
+    vector<vector<TileRoad>> tileRoads(cols * rows);
+    edgeFile >> aux;
+    getline(edgeFile, line);
+    while (getline(edgeFile, line)) {
+        int id1, id2;
+        stringstream lineS(stripLine(line));
+        if (!(lineS >> id1 >> id2))
+            continue;
+        auto t1 = tileOf.find(id1), t2 = tileOf.find(id2);
+        if (t1 == tileOf.end() || t2 == tileOf.end())
+            continue;
+        tileRoads[t1->second].push_back({id1, id2, t1->second, t2->second});
+        if (t1->second != t2->second)
+            tileRoads[t2->second].push_back({id2, id1, t2->second, t1->second});
+    }
+
+    //------------------WRITE------------------
+    ostringstream data, index;
+    data << setprecision(numeric_limits<double>::max_digits10);
+    int nonEmpty = 0;
+    for (int t = 0; t < cols * rows; t++) {
+        if (tileNodes[t].empty() && tileRoads[t].empty())
+            continue;
+        index << "(" << t << ", " << data.tellp() << ")\n";
+        nonEmpty++;
+        data << tileNodes[t].size() << " " << tileRoads[t].size() << "\n";
+        for (auto & n : tileNodes[t])
+            data << "(" << n.getId() << ", " << n.getXCoord() << ", " << n.getYCoord() << ")\n";
+        for (auto & r : tileRoads[t])
+            data << "(" << r.id1 << ", " << r.id2 << ", " << r.otherTile << ")\n";
+    }
+
+    ofstream out("../mapas/" + city + "/tiles_" + city + ".txt", ios::binary);
+    if (!out)
+        return false;
+    out << setprecision(numeric_limits<double>::max_digits10);
+    out << TILES_TAG << " " << TILES_VERSION << " " << source << "\n";
+    out << tileSize << " " << xMin << " " << yMin << " " << cols << " " << rows << "\n";
+    out << nodeTile.size() << "\n";
+    for (auto & p : nodeTile)
+        out << "(" << p.first << ", " << p.second << ")\n";
+    out << nonEmpty << "\n" << index.str() << data.str();
+    return (bool) out;
+}
+
+bool TiledMap::readHeader(istream &in, uint64_t source, double tileSize) {
+    string tag;
+    unsigned version = 0;
+    uint64_t stamp = 0;
+    in >> tag >> version >> stamp >> this->tileSize >> xMin >> yMin >> cols >> rows;
+    // without the map files (source 0) a tiles file of the right size is still used
+    return in && tag == TILES_TAG && version == TILES_VERSION && (source == 0 || stamp == source) && this->tileSize == tileSize;
+}
+
+bool TiledMap::open(string city, double tileSize) {
+    *this = TiledMap();
+    string file = "../mapas/" + city + "/tiles_" + city + ".txt";
+    uint64_t source = mapSourceStamp(city);
+    ifstream in(file, ios::binary);
+    if (!readHeader(in, source, tileSize)) {
+        in.close();
+        if (!build(city, tileSize, source))
+            return false;
+        in.clear();
+        in.open(file, ios::binary);
+        if (!readHeader(in, source, tileSize))
+            return false;
+    }
+
+    string line;
+    int n;
+    in >> n;
+    getline(in, line);
+    nodeTile.reserve(n);
+    for (int i = 0; i < n && getline(in, line); i++) {
+        int id, tile;
+        stringstream lineS(stripLine(line));
+        lineS >> id >> tile;
+        nodeTile.push_back(make_pair(id, tile));
+    }
+    offset.assign(cols * rows, -1);
+    loaded.assign(cols * rows, false);
+    in >> n;
+    getline(in, line);
+    for (int i = 0; i < n && getline(in, line); i++) {
+        int tile;
+        long long pos;
+        stringstream lineS(stripLine(line));
+        lineS >> tile >> pos;
+        if (tile >= 0 && tile < cols * rows)
+            offset[tile] = pos;
+    }
+    if (!in)
+        return false;
+    dataStart = in.tellg();
+    path = file;
+    return true;
+}
+
+bool TiledMap::isOpen() const {
+    return !path.empty();
+}
+
+int TiledMap::getTile(int id) const {
+    auto it = lower_bound(nodeTile.begin(), nodeTile.end(), make_pair(id, numeric_limits<int>::min()));
+    if (it == nodeTile.end() || it->first != id)
+        return -1;
+    return it->second;
+}
+
+int TiledMap::loadAround(Graph<Node> &graph, const vector<int> &ids, double margin) {
+    int colMin = cols, rowMin = rows, colMax = -1, rowMax = -1;
+    for (auto id : ids) {
+        int tile = getTile(id);
+        if (tile < 0)
+            continue;
+        colMin = min(colMin, tile % cols);
+        colMax = max(colMax, tile % cols);
+        rowMin = min(rowMin, tile / cols);
+        rowMax = max(rowMax, tile / cols);
+    }
+    if (colMax < 0)
+        return 0;
+    int extra = (int) ceil(margin / tileSize);
+    vector<int> tiles;
+    for (int r = max(0, rowMin - extra); r <= min(rows - 1, rowMax + extra); r++)
+        for (int c = max(0, colMin - extra); c <= min(cols - 1, colMax + extra); c++)
+            tiles.push_back(c + r * cols);
+    return loadTiles(graph, tiles);
+}
+
+int TiledMap::loadTiles(Graph<Node> &graph, const vector<int> &tiles) {
+    if (!isOpen())
+        return 0;
+    ifstream in(path, ios::binary);
+    vector<bool> inBatch(cols * rows, false);
+    vector<int> batch;
+    vector<TileRoad> roads;
+    string line;
+
+    //------------------NODES------------------
+    for (auto t : tiles) {
+        if (t < 0 || t >= cols * rows || loaded[t] || inBatch[t])
+            continue;
+        inBatch[t] = true;
+        batch.push_back(t);
+        if (offset[t] < 0)
+            continue;
+        int nNodes, nRoads;
+        in.seekg(dataStart + offset[t]);
+        in >> nNodes >> nRoads;
+        getline(in, line);
+        for (int i = 0; i < nNodes && getline(in, line); i++) {
+            int id;
+            double x, y;
+            stringstream lineS(stripLine(line));
+            lineS >> id >> x >> y;
+            graph.addNewVertex(Node(id, x, y));     // every node is in exactly one tile
+        }
+        for (int i = 0; i < nRoads && getline(in, line); i++) {
+            TileRoad r;
+            stringstream lineS(stripLine(line));
+            lineS >> r.id1 >> r.id2 >> r.otherTile;
+            r.tile = t;
+            roads.push_back(r);
+        }
+    }
+    if (batch.empty())
+        return 0;
+
+    vector<Vertex<Node>*> vertexSet = graph.getVertexSet();
+    sort(vertexSet.begin(), vertexSet.end(), sortById);
+    graph.setVertexSet(vertexSet);
+
+    //------------------ROADS------------------
+    for (auto & r : roads) {
+        if (r.otherTile != r.tile && !inBatch[r.otherTile] && !loaded[r.otherTile]) {
+            pending[r.id1].push_back(make_pair(r.id2, r.otherTile));
+            continue;
+        }
+        if (r.otherTile != r.tile && inBatch[r.otherTile] && r.tile > r.otherTile)
+            continue;   // the other tile adds it
+        Vertex<Node>* v1 = vertexBinarySearch(vertexSet, Node(r.id1), 0, vertexSet.size() - 1);
+        Vertex<Node>* v2 = vertexBinarySearch(vertexSet, Node(r.id2), 0, vertexSet.size() - 1);
+        if (v1 == nullptr || v2 == nullptr)
+            continue;
+        graph.addRoad(v1, v2, getEdgeWeight(v1->getInfo().getXCoord(), v1->getInfo().getYCoord(),
+                                            v2->getInfo().getXCoord(), v2->getInfo().getYCoord()));
+        if (loaded[r.otherTile]) {
+            // the road was pending on the other end
+            auto it = pending.find(r.id2);
+            if (it != pending.end()) {
+                auto & roadsOut = it->second;
+                roadsOut.erase(remove(roadsOut.begin(), roadsOut.end(), make_pair(r.id1, r.tile)), roadsOut.end());
+                if (roadsOut.empty())
+                    pending.erase(it);
+            }
+        }
+    }
+
+    int n = 0;
+    for (auto t : batch) {
+        loaded[t] = true;
+        if (offset[t] >= 0) n++;
+    }
+    numLoaded += n;
+    return n;
+}
+
+int TiledMap::expandForPoints(Graph<Node> &graph, const vector<Vertex<Node>*> &points) {
+    vector<int> tiles;
+    vector<Vertex<Node>*> vertexSet = graph.getVertexSet();
+    vector<double> needed(points.size());
+    for (auto a : points) {
+        graph.dijkstraShortestPath(a->getInfo());
+        for (unsigned i = 0; i < points.size(); i++) {
+            Node b = points[i]->getInfo();
+            // a point not reachable yet is looked for up to a generous detour of its straight line distance,
+            // otherwise a point that is really unreachable would pull in the whole component around a
+            needed[i] = points[i]->getDist() != INF ? points[i]->getDist() :
+                    UNREACHABLE_DETOUR * getEdgeWeight(a->getInfo().getXCoord(), a->getInfo().getYCoord(), b.getXCoord(), b.getYCoord());
+        }
+        for (auto & p : pending) {
+            Vertex<Node>* x = vertexBinarySearch(vertexSet, Node(p.first), 0, vertexSet.size() - 1);
+            if (x == nullptr || x->getDist() == INF)
+                continue;
+            // edge weights are never shorter than the straight line, so a path through x to b costs at least this
+            bool better = false;
+            for (unsigned i = 0; i < points.size() && !better; i++) {
+                Node b = points[i]->getInfo();
+                better = x->getDist() + getEdgeWeight(x->getInfo().getXCoord(), x->getInfo().getYCoord(), b.getXCoord(), b.getYCoord()) < needed[i];
+            }
+            if (better)
+                for (auto & road : p.second)
+                    tiles.push_back(road.second);
+        }
+    }
+    return loadTiles(graph, tiles);
+}
+
+bool TiledMap::isBoundary(const Vertex<Node>* v) const {
+    return pending.count(v->getInfo().getId()) > 0;
+}
+
+unsigned TiledMap::getNumTiles() const {
+    unsigned n = 0;
+    for (auto pos : offset)
+        if (pos >= 0) n++;
+    return n;
+}
+
+unsigned TiledMap::getNumLoaded() const {
+    return numLoaded;
+}
+
+double TiledMap::getTileSize() const {
+    return tileSize;
+}
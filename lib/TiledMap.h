@@ -0,0 +1,117 @@
+//
+// TiledMap.h
+//
+
+#ifndef CAL_PROJ_TILEDMAP_H
+#define CAL_PROJ_TILEDMAP_H
+
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+#include "Node.h"
+#include "Graph.h"
+
+#define UNREACHABLE_DETOUR 2    // how far (relative to the straight line) to look for a point not reachable yet
+
+#define TILES_TAG "TILES"       // first word of a tiles file
+#define TILES_VERSION 2
+
+/**
+ * Mapa de uma cidade dividido em tiles quadrados, para carregar apenas a região à volta de um serviço.
+ *
+ * O ficheiro "tiles_<city>.txt" é gerado uma vez a partir dos ficheiros de nodes e edges e guarda, para cada
+ * tile, os seus nodes e as estradas que lhes tocam; as estradas que atravessam a fronteira entre dois tiles
+ * aparecem nos dois. Um índice no início do ficheiro dá o tile de cada node e a posição de cada tile, para
+ * que um tile possa ser lido sem ler os outros.
+ * As estradas que levam a tiles ainda não carregados ficam pendentes no node onde começam (node de fronteira)
+ * e são acrescentadas ao grafo quando o outro tile for carregado.
+ */
+class TiledMap {
+public:
+    TiledMap();
+
+    /**
+     * Abre o mapa em tiles de uma cidade, gerando o ficheiro se ainda não existir, se tiver sido gerado com outro
+     * tamanho de tile ou a partir de outra versão dos ficheiros de nodes e edges (mapSourceStamp).
+     *
+     * @param city string que indica qual cidade a ler
+     * @param tileSize lado de cada tile, em unidades do mapa
+     *
+     * @return false se não for possível ler nem gerar o ficheiro.
+     */
+    bool open(string city, double tileSize = 1000);
+
+    bool isOpen() const;
+
+    /**
+     * @return tile onde está o node com o id dado, -1 se o node não existir.
+     */
+    int getTile(int id) const;
+
+    /**
+     * Carrega os tiles que intersetam o retângulo envolvente dos nodes dados, alargado de margin em todas as direções.
+     *
+     * @param graph grafo onde acrescentar os nodes e estradas
+     * @param ids ids dos nodes que têm de ficar carregados
+     * @param margin margem de segurança, em unidades do mapa
+     *
+     * @return número de tiles carregados.
+     */
+    int loadAround(Graph<Node> &graph, const vector<int> &ids, double margin);
+
+    /**
+     * Carrega os tiles dados que ainda não estejam carregados e liga as estradas pendentes entre eles e os já carregados.
+     * O vertexSet do grafo continua ordenado por id.
+     *
+     * @return número de tiles carregados.
+     */
+    int loadTiles(Graph<Node> &graph, const vector<int> &tiles);
+
+    /**
+     * Garante que os caminhos mais curtos entre os pontos dados estão contidos na região carregada: a partir de cada
+     * ponto a, se para algum node de fronteira x e ponto b a distância de a a x mais a distância em linha reta de x a b
+     * for menor do que a distância de a a b, um caminho melhor pode passar por um tile por carregar, e os tiles do outro
+     * lado dessa fronteira são carregados. Deve ser repetido até devolver 0.
+     * Um ponto ainda inalcançável é procurado até UNREACHABLE_DETOUR vezes a distância em linha reta.
+     *
+     * @param graph grafo carregado
+     * @param points pontos do serviço (garagem, recolhas e fábrica)
+     *
+     * @return número de tiles carregados.
+     */
+    int expandForPoints(Graph<Node> &graph, const vector<Vertex<Node>*> &points);
+
+    /**
+     * @return true se o node tiver estradas para tiles ainda não carregados.
+     */
+    bool isBoundary(const Vertex<Node>* v) const;
+
+    unsigned getNumTiles() const;
+
+    unsigned getNumLoaded() const;
+
+    double getTileSize() const;
+
+private:
+    static bool build(string city, double tileSize, uint64_t source);
+
+    /**
+     * Lê a primeira linha do ficheiro e a grelha.
+     *
+     * @return false se o ficheiro não for um mapa em tiles desta versão gerado com o tamanho e os ficheiros dados.
+     */
+    bool readHeader(istream &in, uint64_t source, double tileSize);
+
+    string path;
+    double tileSize = 0;
+    double xMin = 0, yMin = 0;
+    int cols = 0, rows = 0;
+    vector<long long> offset;                   // position of each tile in the file after the index, -1 if empty
+    vector<bool> loaded;
+    vector<pair<int, int>> nodeTile;            // (node id, tile), sorted by id
+    long long dataStart = 0;
+    unordered_map<int, vector<pair<int, int>>> pending;     // node id -> (other node id, other tile) of roads to unloaded tiles
+    unsigned numLoaded = 0;
+};
+
+#endif //CAL_PROJ_TILEDMAP_H
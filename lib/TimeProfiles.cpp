@@ -0,0 +1,87 @@
+//
+// TimeProfiles.cpp
+//
+
+#include <algorithm>
+#include <cmath>
+#include "TimeProfiles.h"
+
+TimeProfiles::TimeProfiles() : speed(1), minFactor(1) {}
+
+TimeProfiles::TimeProfiles(const vector<double> & breakpoints, double speed) : breakpoints(breakpoints), speed(speed), minFactor(1) {
+    sort(this->breakpoints.begin(), this->breakpoints.end());
+}
+
+int TimeProfiles::addProfile(const vector<float> & profileFactors) {
+    if (profileFactors.size() != breakpoints.size() || breakpoints.empty())
+        return -1;
+
+    auto it = known.find(profileFactors);
+    if (it != known.end())
+        return it->second;
+
+    int id = getNumProfiles();
+    factors.insert(factors.end(), profileFactors.begin(), profileFactors.end());
+    known[profileFactors] = id;
+    for (auto f : profileFactors)
+        if (f < minFactor) minFactor = f;
+    return id;
+}
+
+double TimeProfiles::getFactor(int profile, double time) const {
+    if (profile < 0 || profile >= (int) getNumProfiles())
+        return 1;
+
+    unsigned n = breakpoints.size();
+    const float * f = &factors[profile * n];
+    if (n == 1)
+        return f[0];
+
+    time = fmod(time, SECONDS_PER_DAY);
+    if (time < 0) time += SECONDS_PER_DAY;
+
+    // find the interval [t0, t1[ containing time, wrapping around midnight
+    unsigned i = upper_bound(breakpoints.begin(), breakpoints.end(), time) - breakpoints.begin();
+    double t0, t1, f0, f1;
+    if (i == 0 || i == n) {
+        t0 = breakpoints[n - 1];
+        t1 = breakpoints[0] + SECONDS_PER_DAY;
+        f0 = f[n - 1];
+        f1 = f[0];
+        if (i == 0) time += SECONDS_PER_DAY;
+    } else {
+        t0 = breakpoints[i - 1];
+        t1 = breakpoints[i];
+        f0 = f[i - 1];
+        f1 = f[i];
+    }
+    return f0 + (f1 - f0) * (time - t0) / (t1 - t0);
+}
+
+double TimeProfiles::travelTime(int profile, double length, double departure) const {
+    return length / speed * getFactor(profile, departure);
+}
+
+double TimeProfiles::getSpeed() const {
+    return speed;
+}
+
+void TimeProfiles::setSpeed(double speed) {
+    TimeProfiles::speed = speed;
+}
+
+double TimeProfiles::getMinFactor() const {
+    return minFactor;
+}
+
+const vector<double> & TimeProfiles::getBreakpoints() const {
+    return breakpoints;
+}
+
+unsigned TimeProfiles::getNumProfiles() const {
+    return breakpoints.empty() ? 0 : factors.size() / breakpoints.size();
+}
+
+bool TimeProfiles::empty() const {
+    return getNumProfiles() == 0;
+}
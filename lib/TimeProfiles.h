@@ -0,0 +1,79 @@
+//
+// TimeProfiles.h
+//
+
+#ifndef CAL_PROJ_TIMEPROFILES_H
+#define CAL_PROJ_TIMEPROFILES_H
+
+#include <vector>
+#include <map>
+
+using namespace std;
+
+#define SECONDS_PER_DAY 86400.0
+
+/**
+ * Tabela de perfis de tempo de viagem partilhada por todas as arestas de um grafo.
+ *
+ * Todos os perfis usam os mesmos instantes (breakpoints, em segundos desde a meia-noite) e cada perfil
+ * guarda apenas um fator multiplicativo por instante, sobre o tempo de viagem em fluxo livre (comprimento / velocidade).
+ * Entre instantes o fator é interpolado linearmente e o perfil repete-se a cada 24h.
+ * Perfis iguais são guardados uma única vez, pelo que cada aresta só precisa de guardar o indice do seu perfil.
+ */
+class TimeProfiles {
+public:
+    TimeProfiles();
+
+    TimeProfiles(const vector<double> & breakpoints, double speed);
+
+    /**
+     * Adiciona um perfil à tabela, reutilizando um perfil igual caso já exista.
+     *
+     * @param profileFactors um fator por breakpoint
+     *
+     * @return indice do perfil, ou -1 se o número de fatores não corresponder ao número de breakpoints.
+     */
+    int addProfile(const vector<float> & profileFactors);
+
+    /**
+     * Fator de congestionamento de um perfil num dado instante.
+     *
+     * @param profile indice do perfil (-1 corresponde ao fluxo livre)
+     * @param time instante em segundos (qualquer valor, é reduzido a um dia)
+     *
+     * @return fator multiplicativo sobre o tempo em fluxo livre.
+     */
+    double getFactor(int profile, double time) const;
+
+    /**
+     * Tempo necessário para percorrer uma aresta partindo num dado instante.
+     *
+     * @param profile indice do perfil da aresta
+     * @param length comprimento da aresta (metros)
+     * @param departure instante de partida (segundos)
+     *
+     * @return tempo de viagem em segundos.
+     */
+    double travelTime(int profile, double length, double departure) const;
+
+    double getSpeed() const;
+
+    void setSpeed(double speed);
+
+    double getMinFactor() const;
+
+    const vector<double> & getBreakpoints() const;
+
+    unsigned getNumProfiles() const;
+
+    bool empty() const;
+
+private:
+    vector<double> breakpoints;     // instants shared by every profile, sorted, in [0, SECONDS_PER_DAY)
+    vector<float> factors;          // profile p occupies [p*breakpoints.size(), (p+1)*breakpoints.size())
+    map<vector<float>, int> known;  // deduplication of equal profiles
+    double speed;                   // free flow speed (m/s)
+    double minFactor;               // smallest factor of all profiles, used as A* lower bound
+};
+
+#endif //CAL_PROJ_TIMEPROFILES_H
@@ -0,0 +1,159 @@
+//
+// TourOptimizer.cpp
+//
+
+#include <algorithm>
+#include "TourOptimizer.h"
+
+TourOptimizer::TourOptimizer(const CostMatrix &matrix) : matrix(matrix) {}
+
+double TourOptimizer::tourCost(const vector<unsigned> &tour) const {
+    double cost = 0;
+    for (unsigned k = 0; k + 1 < tour.size(); k++)
+        cost += matrix.cost(tour[k], tour[k + 1]);
+    return cost;
+}
+
+vector<unsigned> TourOptimizer::nearestNeighbour(unsigned start, const vector<unsigned> &points, unsigned end) const {
+    vector<unsigned> tour(1, start);
+    vector<bool> visited(points.size(), false);
+    for (unsigned k = 0; k < points.size(); k++) {
+        int next = -1;
+        for (unsigned j = 0; j < points.size(); j++)
+            if (!visited[j] && (next < 0 || matrix.cost(tour.back(), points[j]) < matrix.cost(tour.back(), points[next])))
+                next = j;
+        visited[next] = true;
+        tour.push_back(points[next]);
+    }
+    tour.push_back(end);
+    return tour;
+}
+
+void TourOptimizer::prefixCosts(const vector<unsigned> &tour) {
+    forward.assign(tour.size(), 0);
+    backward.assign(tour.size(), 0);
+    unknown.assign(tour.size(), 0);
+    for (unsigned k = 1; k < tour.size(); k++) {
+        // INF is the largest double, so adding it would saturate the sums: INF legs are counted apart instead
+        double there = matrix.cost(tour[k - 1], tour[k]), back = matrix.cost(tour[k], tour[k - 1]);
+        forward[k] = forward[k - 1] + (there == INF ? 0 : there);
+        backward[k] = backward[k - 1] + (back == INF ? 0 : back);
+        unknown[k] = unknown[k - 1] + (there == INF || back == INF);
+    }
+}
+
+bool TourOptimizer::twoOpt(vector<unsigned> &tour, unsigned first, unsigned last, CancelToken *cancel) {
+    unsigned n = tour.size();
+    if (n < 4)
+        return false;
+    bool improved = false;
+    prefixCosts(tour);
+    for (unsigned i = max(first, 1u); i < min(last, n - 2); i++) {
+        if (cancel != nullptr && cancel->poll())
+            break;
+        for (unsigned j = i + 1; j < n - 1; j++) {
+            if (unknown[j] != unknown[i] || matrix.cost(tour[i - 1], tour[i]) == INF || matrix.cost(tour[j], tour[j + 1]) == INF ||
+                matrix.cost(tour[i - 1], tour[j]) == INF || matrix.cost(tour[i], tour[j + 1]) == INF)
+                continue;
+            // reverse tour[i..j]: the edges inside it are travelled the other way
+            double before = matrix.cost(tour[i - 1], tour[i]) + (forward[j] - forward[i]) + matrix.cost(tour[j], tour[j + 1]);
+            double after = matrix.cost(tour[i - 1], tour[j]) + (backward[j] - backward[i]) + matrix.cost(tour[i], tour[j + 1]);
+            if (after < before - TOUR_EPSILON) {
+                reverse(tour.begin() + i, tour.begin() + j + 1);
+                prefixCosts(tour);
+                moves++;
+                improved = true;
+            }
+        }
+    }
+    return improved;
+}
+
+bool TourOptimizer::orOpt(vector<unsigned> &tour, unsigned first, unsigned last, CancelToken *cancel) {
+    unsigned n = tour.size();
+    bool improved = false;
+    for (unsigned len = 1; len <= OR_OPT_SEGMENT; len++) {
+        for (unsigned i = max(first, 1u); i < min(last, n - 1) && i + len < n; i++) {
+            if (cancel != nullptr && cancel->poll())
+                return improved;
+            // segment tour[i..i+len-1], between a and b
+            unsigned a = tour[i - 1], s = tour[i], e = tour[i + len - 1], b = tour[i + len];
+            if (matrix.cost(a, s) == INF || matrix.cost(e, b) == INF || matrix.cost(a, b) == INF)
+                continue;
+            double removed = matrix.cost(a, s) + matrix.cost(e, b) - matrix.cost(a, b);
+            for (unsigned j = 0; j + 1 < n; j++) {
+                if (j + 1 >= i && j < i + len)
+                    continue;   // the gap must be outside the segment and not the one it leaves
+                unsigned p = tour[j], q = tour[j + 1];
+                if (matrix.cost(p, s) == INF || matrix.cost(e, q) == INF || matrix.cost(p, q) == INF)
+                    continue;
+                double added = matrix.cost(p, s) + matrix.cost(e, q) - matrix.cost(p, q);
+                if (added < removed - TOUR_EPSILON) {
+                    vector<unsigned> segment(tour.begin() + i, tour.begin() + i + len);
+                    tour.erase(tour.begin() + i, tour.begin() + i + len);
+                    unsigned at = j < i ? j + 1 : j + 1 - len;
+                    tour.insert(tour.begin() + at, segment.begin(), segment.end());
+                    moves++;
+                    improved = true;
+                    break;
+                }
+            }
+        }
+    }
+    return improved;
+}
+
+double TourOptimizer::insert(vector<unsigned> &tour, unsigned point) {
+    double best = INF;
+    unsigned at = 0;
+    for (unsigned k = 0; k + 1 < tour.size(); k++) {
+        if (matrix.cost(tour[k], point) == INF || matrix.cost(point, tour[k + 1]) == INF || matrix.cost(tour[k], tour[k + 1]) == INF)
+            continue;
+        double delta = matrix.cost(tour[k], point) + matrix.cost(point, tour[k + 1]) - matrix.cost(tour[k], tour[k + 1]);
+        if (delta < best) {
+            best = delta;
+            at = k + 1;
+        }
+    }
+    if (best != INF)
+        tour.insert(tour.begin() + at, point);
+    return best;
+}
+
+bool TourOptimizer::relocate(vector<unsigned> &tour, unsigned point) {
+    unsigned i = find(tour.begin(), tour.end(), point) - tour.begin();
+    if (i == 0 || i + 1 >= tour.size() || matrix.cost(tour[i - 1], point) == INF || matrix.cost(point, tour[i + 1]) == INF ||
+        matrix.cost(tour[i - 1], tour[i + 1]) == INF)
+        return false;
+    double removed = matrix.cost(tour[i - 1], point) + matrix.cost(point, tour[i + 1]) - matrix.cost(tour[i - 1], tour[i + 1]);
+    tour.erase(tour.begin() + i);
+    double added = insert(tour, point);
+    if (added < removed - TOUR_EPSILON) {
+        moves++;
+        return true;
+    }
+    // put it back where it was
+    if (added != INF)
+        tour.erase(find(tour.begin(), tour.end(), point));
+    tour.insert(tour.begin() + i, point);
+    return false;
+}
+
+unsigned TourOptimizer::optimize(vector<unsigned> &tour, const function<void(const vector<unsigned> &, double)> &onImprovement,
+                                 CancelToken *cancel) {
+    unsigned passes = 0;
+    while (cancel == nullptr || !cancel->isCancelled()) {
+        bool improved = twoOpt(tour, 1, UINT_MAX, cancel);
+        improved = orOpt(tour, 1, UINT_MAX, cancel) || improved;
+        if (!improved)
+            break;
+        passes++;
+        if (onImprovement)
+            onImprovement(tour, tourCost(tour));
+    }
+    return passes;
+}
+
+unsigned TourOptimizer::getMoves() const {
+    return moves;
+}
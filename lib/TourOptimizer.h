@@ -0,0 +1,99 @@
+//
+// TourOptimizer.h
+//
+
+#ifndef CAL_PROJ_TOUROPTIMIZER_H
+#define CAL_PROJ_TOUROPTIMIZER_H
+
+#include <vector>
+#include <functional>
+#include "CostMatrix.h"
+
+using namespace std;
+
+#define OR_OPT_SEGMENT 3        // longest sequence of points moved by Or-opt
+#define TOUR_EPSILON 1e-6       // smallest gain that counts as an improvement
+
+/**
+ * Pesquisa local sobre a ordem dos pontos de um serviço. Uma volta (tour) é uma sequência de índices de uma
+ * CostMatrix que começa na garagem e acaba na fábrica; estes dois pontos nunca mudam de lugar.
+ *
+ * São usadas duas vizinhanças, sempre aceitando a primeira melhoria encontrada:
+ * 2-opt inverte uma subsequência de pontos e Or-opt muda uma sequência de até OR_OPT_SEGMENT pontos para outro
+ * lugar da volta. Como os custos não são simétricos (sentidos únicos), o custo de uma subsequência invertida é
+ * calculado com somas acumuladas dos custos nos dois sentidos. Um custo INF (perna desconhecida ou sem caminho)
+ * nunca entra num movimento.
+ */
+class TourOptimizer {
+public:
+    explicit TourOptimizer(const CostMatrix &matrix);
+
+    double tourCost(const vector<unsigned> &tour) const;
+
+    /**
+     * Volta pelo vizinho mais próximo, como sortPoints.
+     *
+     * @param start índice da garagem
+     * @param points índices dos pontos de recolha
+     * @param end índice da fábrica
+     */
+    vector<unsigned> nearestNeighbour(unsigned start, const vector<unsigned> &points, unsigned end) const;
+
+    /**
+     * Uma passagem de 2-opt pelas inversões que começam em [first, last) (a volta inteira por omissão).
+     *
+     * @return true se a volta melhorou.
+     */
+    bool twoOpt(vector<unsigned> &tour, unsigned first = 1, unsigned last = UINT_MAX, CancelToken *cancel = nullptr);
+
+    /**
+     * Uma passagem de Or-opt pelas sequências que começam em [first, last) (a volta inteira por omissão).
+     *
+     * @return true se a volta melhorou.
+     */
+    bool orOpt(vector<unsigned> &tour, unsigned first = 1, unsigned last = UINT_MAX, CancelToken *cancel = nullptr);
+
+    /**
+     * Inserção mais barata: põe um ponto entre os dois pontos seguidos da volta onde aumenta menos o custo
+     * (nunca antes da garagem nem depois da fábrica).
+     *
+     * @return aumento do custo da volta, INF se o ponto não puder ser inserido (nesse caso a volta não muda).
+     */
+    double insert(vector<unsigned> &tour, unsigned point);
+
+    /**
+     * Muda um ponto da volta para o sítio onde fica mais barato, se isso melhorar a volta (Or-opt de um só ponto).
+     * Só usa custos que envolvem o próprio ponto e os dos pares seguidos da volta.
+     *
+     * @return true se a volta melhorou.
+     */
+    bool relocate(vector<unsigned> &tour, unsigned point);
+
+    /**
+     * Aplica 2-opt e Or-opt até nenhum melhorar a volta.
+     *
+     * @param tour volta a melhorar
+     * @param onImprovement chamada com a volta e o seu custo após cada passagem que a melhorou (pode ser vazia)
+     * @param cancel token que pode interromper a pesquisa, ficando a melhor volta encontrada até então
+     *
+     * @return número de passagens que melhoraram a volta.
+     */
+    unsigned optimize(vector<unsigned> &tour, const function<void(const vector<unsigned> &, double)> &onImprovement,
+                      CancelToken *cancel = nullptr);
+
+    /**
+     * @return número de movimentos aplicados desde a construção.
+     */
+    unsigned getMoves() const;
+
+private:
+    void prefixCosts(const vector<unsigned> &tour);
+
+    const CostMatrix &matrix;
+    vector<double> forward;     // forward[k]: cost of tour[0..k] in tour order
+    vector<double> backward;    // backward[k]: cost of tour[0..k] travelled from tour[k] back to tour[0]
+    vector<unsigned> unknown;   // unknown[k]: legs of tour[0..k] with an INF cost in either direction, left out of the sums
+    unsigned moves = 0;
+};
+
+#endif //CAL_PROJ_TOUROPTIMIZER_H
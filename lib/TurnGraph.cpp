@@ -0,0 +1,206 @@
+//
+// TurnGraph.cpp
+//
+
+#include <fstream>
+#include <sstream>
+#include <functional>
+#include "TurnGraph.h"
+
+TurnGraph::TurnGraph() {}
+
+TurnGraph::TurnGraph(const Graph<Node> &graph) : vertices(graph.getVertexSet()) {
+    firstEdge.push_back(0);
+    for (unsigned v = 0; v < vertices.size(); v++) {
+        for (auto e : vertices[v]->getAdj()) {
+            edgeTail.push_back(v);
+            edgeHead.push_back(e.getDest()->posAtVec);
+            edgeWeight.push_back(e.getWeight());
+        }
+        firstEdge.push_back(edgeHead.size());
+    }
+    dist.assign(edgeHead.size(), INF);
+    parent.assign(edgeHead.size(), -1);
+}
+
+int TurnGraph::findEdge(unsigned from, unsigned to) const {
+    for (unsigned e = firstEdge[from]; e < firstEdge[from + 1]; e++)
+        if (edgeHead[e] == to) return e;
+    return -1;
+}
+
+int TurnGraph::loadRestrictions(string city) {
+    ifstream turnFile;
+    string line;
+    int total = 0;
+    line = "../files/" + city + "/" + city + "_turns.txt";
+    turnFile.open(line);
+    if (!turnFile)
+        return 0;
+
+    while (getline(turnFile, line)) {
+        size_t pos = line.find(')');
+        if (pos != string::npos)
+            line = line.substr(1, pos);
+        line.erase(remove(line.begin(), line.end(), ','), line.end());  //removes ','
+
+        int from, via, to;
+        stringstream lineS(line);
+        if (!(lineS >> from >> via >> to)) continue;
+        if (addRestriction(from, via, to)) total++;
+        else cout << "Ignoring turn restriction (" << from << ", " << via << ", " << to << ")\n";
+    }
+    return total;
+}
+
+bool TurnGraph::addRestriction(int fromId, int viaId, int toId) {
+    auto byId = [](const Vertex<Node>* v, int id) { return v->getInfo().getId() < id; };
+    auto from = lower_bound(vertices.begin(), vertices.end(), fromId, byId);
+    auto via = lower_bound(vertices.begin(), vertices.end(), viaId, byId);
+    auto to = lower_bound(vertices.begin(), vertices.end(), toId, byId);
+    if (from == vertices.end() || via == vertices.end() || to == vertices.end())
+        return false;
+    if ((*from)->getInfo().getId() != fromId || (*via)->getInfo().getId() != viaId || (*to)->getInfo().getId() != toId)
+        return false;
+
+    int inEdge = findEdge(from - vertices.begin(), via - vertices.begin());
+    int outEdge = findEdge(via - vertices.begin(), to - vertices.begin());
+    if (inEdge < 0 || outEdge < 0)
+        return false;
+
+    pair<unsigned, unsigned> turn(inEdge, outEdge);
+    auto it = lower_bound(forbidden.begin(), forbidden.end(), turn);
+    if (it == forbidden.end() || *it != turn)
+        forbidden.insert(it, turn);
+    return true;
+}
+
+double TurnGraph::turnCost(unsigned inEdge, unsigned outEdge) const {
+    if (binary_search(forbidden.begin(), forbidden.end(), make_pair(inEdge, outEdge)))
+        return INF;
+
+    unsigned from = edgeTail[inEdge], via = edgeHead[inEdge], to = edgeHead[outEdge];
+    if (to == from) {
+        // a van can only turn around where there is nowhere else to go
+        return firstEdge[via + 1] - firstEdge[via] == 1 ? uTurnPenalty : INF;
+    }
+
+    Node a = vertices[from]->getInfo(), b = vertices[via]->getInfo(), c = vertices[to]->getInfo();
+    double x1 = b.getXCoord() - a.getXCoord(), y1 = b.getYCoord() - a.getYCoord();
+    double x2 = c.getXCoord() - b.getXCoord(), y2 = c.getYCoord() - b.getYCoord();
+    double norm = hypot(x1, y1) * hypot(x2, y2);
+    if (norm == 0)
+        return 0;
+    double angle = acos(max(-1.0, min(1.0, (x1 * x2 + y1 * y2) / norm)));   // 0 when going straight
+    if (angle > 2 * M_PI / 3)
+        return sharpTurnPenalty;
+    return turnPenalty * angle / M_PI;
+}
+
+vector<Vertex<Node>*> TurnGraph::shortestPath(Vertex<Node>* orig, Vertex<Node>* dest, int incomingEdge, CancelToken *cancel) {
+    typedef pair<double, unsigned> QueueEntry;
+    priority_queue<QueueEntry, vector<QueueEntry>, greater<QueueEntry>> q;
+    vector<Vertex<Node>*> res;
+    unsigned s = orig->posAtVec, t = dest->posAtVec;
+
+    for (auto e : touched) {
+        dist[e] = INF;
+        parent[e] = -1;
+    }
+    touched.clear();
+    lastOrig = s;
+    lastFound = -1;
+    lastEdge = incomingEdge;
+    lastCost = 0;
+
+    if (s == t) {
+        res.push_back(orig);
+        return res;
+    }
+
+    for (unsigned e = firstEdge[s]; e < firstEdge[s + 1]; e++) {
+        double cost = edgeWeight[e] + (incomingEdge < 0 ? 0 : turnCost(incomingEdge, e));
+        if (cost < dist[e]) {
+            dist[e] = cost;
+            touched.push_back(e);
+            q.push(QueueEntry(cost, e));
+        }
+    }
+
+    int found = -1;
+    unsigned settled = 0;
+    while (!q.empty()) {
+        if (shouldStop(cancel, settled))
+            break;
+        auto top = q.top();
+        q.pop();
+        unsigned e = top.second;
+        if (top.first > dist[e]) continue;  // stale entry
+        if (edgeHead[e] == t) {
+            found = e;
+            break;
+        }
+        unsigned v = edgeHead[e];
+        for (unsigned f = firstEdge[v]; f < firstEdge[v + 1]; f++) {
+            double cost = dist[e] + turnCost(e, f);
+            if (cost == INF) continue;
+            cost += edgeWeight[f];
+            if (cost < dist[f]) {
+                if (dist[f] == INF) touched.push_back(f);
+                dist[f] = cost;
+                parent[f] = e;
+                q.push(QueueEntry(cost, f));
+            }
+        }
+    }
+
+    lastEdge = lastFound = found;
+    if (found < 0) {
+        lastCost = INF;
+        return res;
+    }
+    lastCost = dist[found];
+
+    vector<uint32_t> path;
+    appendPath(path);
+    for (auto v : path)
+        res.push_back(vertices[v]);
+    return res;
+}
+
+double TurnGraph::appendPath(vector<uint32_t> &path) const {
+    if (lastCost == INF)
+        return INF;
+    size_t start = path.size();
+    double length = 0;
+    // map the edge chain back to the vertices it goes through
+    for (int e = lastFound; e >= 0; e = parent[e]) {
+        path.push_back(edgeHead[e]);
+        length += edgeWeight[e];
+    }
+    path.push_back(lastOrig);
+    reverse(path.begin() + start, path.end());
+    if (start > 0 && path[start - 1] == path[start])
+        path.erase(path.begin() + start);
+    return length;
+}
+
+int TurnGraph::getLastEdge() const {
+    return lastEdge;
+}
+
+double TurnGraph::getLastCost() const {
+    return lastCost;
+}
+
+unsigned TurnGraph::getNumEdges() const {
+    return edgeHead.size();
+}
+
+void TurnGraph::setUTurnPenalty(double uTurnPenalty) {
+    TurnGraph::uTurnPenalty = uTurnPenalty;
+}
+
+void TurnGraph::setSharpTurnPenalty(double sharpTurnPenalty) {
+    TurnGraph::sharpTurnPenalty = sharpTurnPenalty;
+}
@@ -0,0 +1,110 @@
+//
+// TurnGraph.h
+//
+
+#ifndef CAL_PROJ_TURNGRAPH_H
+#define CAL_PROJ_TURNGRAPH_H
+
+#include <string>
+#include "Node.h"
+#include "Graph.h"
+
+/**
+ * Representação baseada em arestas (line graph) de um Graph<Node>, usada para encaminhamento com custos de viragem.
+ *
+ * Cada aresta dirigida do grafo original é um estado da pesquisa e as transições são as viragens num vértice.
+ * O line graph nunca é materializado: as transições são geradas a partir da lista de adjacências compacta
+ * quando a aresta é expandida, e apenas as viragens proibidas são guardadas (tabela ordenada de pares de arestas).
+ */
+class TurnGraph {
+public:
+    TurnGraph();
+
+    /**
+     * Indexa as arestas dirigidas do grafo. Deve ser construido depois de remover as estradas cortadas.
+     *
+     * @param graph grafo a processar
+     */
+    explicit TurnGraph(const Graph<Node> &graph);
+
+    /**
+     * Lê as viragens proibidas do ficheiro "<city>_turns.txt" da pasta da cidade, uma por linha
+     * no formato "(idOrigem, idVia, idDestino)". O ficheiro é opcional.
+     *
+     * @param city string que indica qual cidade a ler
+     *
+     * @return número de viragens proibidas lidas.
+     */
+    int loadRestrictions(string city);
+
+    /**
+     * Proibe a viragem from -> via -> to.
+     *
+     * @return false se alguma das estradas não existir.
+     */
+    bool addRestriction(int fromId, int viaId, int toId);
+
+    /**
+     * Custo de passar da aresta inEdge para a aresta outEdge (INF se a viragem for proibida).
+     */
+    double turnCost(unsigned inEdge, unsigned outEdge) const;
+
+    /**
+     * Caminho mais curto com custos de viragem entre dois vértices.
+     *
+     * @param orig vértice de partida
+     * @param dest vértice de chegada
+     * @param incomingEdge aresta pela qual se chegou a orig (-1 se o veiculo está parado), usada para
+     * encadear pernas sem inversões de marcha nos pontos de recolha
+     * @param cancel token que pode interromper a pesquisa (nullptr para correr até ao fim)
+     *
+     * @return sequência de vértices de orig a dest, vazia se dest for inalcançável ou a pesquisa for interrompida.
+     */
+    vector<Vertex<Node>*> shortestPath(Vertex<Node>* orig, Vertex<Node>* dest, int incomingEdge = -1, CancelToken *cancel = nullptr);
+
+    /**
+     * Acrescenta a path os índices dos vértices do último caminho calculado, sem repetir o vértice de partida
+     * se este já for o último elemento de path.
+     *
+     * @return comprimento do caminho (sem custos de viragem), INF se não houve caminho.
+     */
+    double appendPath(vector<uint32_t> &path) const;
+
+    /**
+     * @return aresta pela qual o último caminho calculado chegou ao destino (-1 se não houve nenhuma).
+     */
+    int getLastEdge() const;
+
+    double getLastCost() const;
+
+    unsigned getNumEdges() const;
+
+    void setUTurnPenalty(double uTurnPenalty);
+
+    void setSharpTurnPenalty(double sharpTurnPenalty);
+
+private:
+    int findEdge(unsigned from, unsigned to) const;
+
+    vector<Vertex<Node>*> vertices;             // vertex index -> vertex (the graph's vertexSet)
+    vector<unsigned> firstEdge;                 // edges leaving vertex v are [firstEdge[v], firstEdge[v+1])
+    vector<unsigned> edgeHead;                  // destination vertex of each edge
+    vector<unsigned> edgeTail;                  // source vertex of each edge
+    vector<double> edgeWeight;
+    vector<pair<unsigned, unsigned>> forbidden; // sorted (inEdge, outEdge) pairs
+
+    double uTurnPenalty = 200;      // only allowed at dead ends
+    double sharpTurnPenalty = 40;   // turns over 120 degrees
+    double turnPenalty = 10;        // any other turn, scaled by the angle
+
+    // search state, sized once and reset only where it was touched
+    vector<double> dist;
+    vector<int> parent;
+    vector<unsigned> touched;
+    unsigned lastOrig = 0;
+    int lastFound = -1;     // last edge of the last path (-1 if it was empty or not found)
+    int lastEdge = -1;
+    double lastCost = INF;
+};
+
+#endif //CAL_PROJ_TURNGRAPH_H
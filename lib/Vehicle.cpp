@@ -13,15 +13,15 @@ void Vehicle::setId(int id) {
     Vehicle::id = id;
 }
 
-const vector<Edge<Node>> & Vehicle::getPRordenados() const{
+const Route & Vehicle::getRoute() const{
 return
-PRordenados;
+route;
 }
 
-void Vehicle::setPRordenados(const vector<Edge<Node>> & pRordenados) {
-    PRordenados = pRordenados;
+void Vehicle::setRoute(const Route & route) {
+    Vehicle::route = route;
 }
 
-Vehicle::Vehicle(int id, const vector<Edge<Node>> & pRordenados) : id(id), PRordenados(pRordenados) {}
+Vehicle::Vehicle(int id, const Route & route) : id(id), route(route) {}
 
 Vehicle::Vehicle(int id) : id(id) {}
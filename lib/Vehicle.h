@@ -5,14 +5,13 @@
 #ifndef CAL_PROJ_VEHICLE_H
 #define CAL_PROJ_VEHICLE_H
 
-#include "Node.h"
-#include "Graph.h"
+#include "Route.h"
 
 class Vehicle{
 public:
     Vehicle(){}
 
-    Vehicle(int id, const vector<Edge<Node>> & pRordenados);
+    Vehicle(int id, const Route & route);
 
     Vehicle(int id);
 
@@ -20,13 +19,13 @@ public:
 
     void setId(int id);
 
-    const vector<Edge<Node>> & getPRordenados() const;
+    const Route & getRoute() const;
 
-    void setPRordenados(const vector<Edge<Node>> & pRordenados);
+    void setRoute(const Route & route);
 
 private:
     int id;
-    vector<Edge<Node>> PRordenados;
+    Route route;    // vertices to travel through, in order, as positions in the graph's vertexSet
 
 };
 #endif //CAL_PROJ_VEHICLE_H
@@ -10,28 +10,58 @@
 int main() {
 	Graph<Node> graph;
     vector<Vertex<Node>*> conexo;
+    TimeProfiles profiles;
+    TurnGraph turns;
+    ContractionHierarchy ch;
+    TiledMap tiles;
+    GraphImage image;       // stays mapped while its city is loaded, the cluster workers search it
     int aux;
     string city;
     bool canDisplay=false;
 
 	int option;
     cout << "HELLO, WHAT DO YOU WANT TO DO?" <<  endl;
-    while ((option=mainMenu())!=5){
+    while ((option=mainMenu())!=8){
         switch(option){
             case 0:
                 aux=chooseCity(city);
                 if(aux<0){
                     break;
                 }
-                cout<<"Reading graph file...\n";
-                graph = loadGraph(city);
+                if(chooseLoadMode()==1){
+                    cout<<"Opening tiled map (built from the graph files the first time)...\n";
+                    graph = Graph<Node>();
+                    image.detach();
+                    if(!tiles.open(city)){
+                        cout<<"Couldn't open the tiled map!\n";
+                        break;
+                    }
+                    tiles.loadAround(graph,readGarageIds(city),REGION_MARGIN);
+                }
+                else{
+                    tiles = TiledMap();
+                    // the shared image is built from the graph files the first time, later runs only map it
+                    if(openCityImage(image,city)){
+                        cout<<"Reading graph image...\n";
+                        graph = loadGraphImage(image);
+                    }
+                    else{
+                        cout<<"Reading graph file...\n";
+                        graph = loadGraphParallel(city);
+                    }
+                }
                 cout<<"Done!\n\n";
                 cout<<"Generating CFC...\n";
-                conexo = readFromCityFile(graph,city);
+                conexo = readFromCityFile(graph,city,tiles.isOpen());
+                clearDepotPartition(city);
                 if(conexo.empty()){
                     cout<<"failed to create CFC\n";
                     break;
                 }
+                profiles = loadTimeProfiles(graph,city);
+                turns = TurnGraph(graph);
+                turns.loadRestrictions(city);
+                ch = ContractionHierarchy();
                 canDisplay=true;
                 cout<<"Done!\n\n";
                 break;
@@ -58,23 +88,108 @@ int main() {
                 }
                 help(conexo);
                 break;
+            case 5: {
+                if(!canDisplay){
+                    cout<<"You must first load a graph!\n";
+                    break;
+                }
+                vector<vector<Node>> routes = findAlternatives(graph);
+                if(!routes.empty()){
+                    cout<<"Displaying alternative routes!\n";
+                    displayAlternatives(routes);
+                }
+                break;
+            }
+            case 6: {
+                if(!canDisplay){
+                    cout<<"You must first load a graph!\n";
+                    break;
+                }
+                Vertex<Node>* centre;
+                vector<Isochrone> isochrones = findIsochrones(graph, profiles, centre);
+                if(!isochrones.empty()){
+                    cout<<"Displaying isochrones!\n";
+                    displayIsochrones(isochrones, centre);
+                }
+                break;
+            }
+            case 7:
+                if(!canDisplay){
+                    cout<<"You must first load a graph!\n";
+                    break;
+                }
+                compareRelaxKernels(graph);
+                break;
             case 4:
                 if(!canDisplay){
                     cout<<"You must first load a graph!\n";
                     break;
                 }
+                string serviceFile;
+                if(tiles.isOpen()){
+                    serviceFile = askServiceFile(city);
+                    cout<<"Loading the region of the service...\n";
+                    if(!loadServiceRegion(graph,tiles,city,serviceFile,conexo)){
+                        cout<<"Failed to load the region of the service!\n";
+                        break;
+                    }
+                    cout<<tiles.getNumLoaded()<<" of "<<tiles.getNumTiles()<<" tiles loaded ("<<graph.getNumVertex()<<" nodes)\n";
+                    profiles = loadTimeProfiles(graph,city);
+                    turns = TurnGraph(graph);
+                    turns.loadRestrictions(city);
+                    ch = ContractionHierarchy();
+                }
                 cout<<"Reading service...\n";
-                Service servico = readService(conexo,city);
+                Service servico = readService(conexo,city,serviceFile);
                 cout<<"Done!\n";
                 if(servico.getPontosRecolha().empty()){
                     cout<<"The service you provided has no pickup point accessible from our garage!\n";
                     break;
                 }
-                cout<<"Calculating path...\n";
-                proccessService(servico,graph);
-                cout<<"Done!\n";
-                cout<<"Displaying service!\n";
-                displayService(servico);
+                vector<Service> servicos = splitServiceByDepot(servico,graph,city);
+                int mode = chooseRoutingMode();
+                for(auto & depotService : servicos){
+                    if(servicos.size() > 1)
+                        cout<<"Garage "<<depotService.getGaragem()->getInfo().getId()<<": "<<depotService.getPontosRecolha().size()<<" pickup points\n";
+                    cout<<"Calculating path...\n";
+                    if(mode==1){
+                        CancelToken cancel(chooseTimeLimit());
+                        GraphViewer* gv = nullptr;
+                        proccessService(depotService,graph,[&](const RouteUpdate & update){
+                            cout<<(update.final ? "Final route: " : "Route found: ")<<update.cost<<" after "<<update.elapsed<<" ms\n";
+                            if(update.final)
+                                return;
+                            // redraw the service with the better route
+                            if(gv != nullptr)
+                                gv->closeWindow();
+                            gv = displayService(depotService, graph);
+                        },&cancel);
+                        cout<<"Done!\n";
+                        continue;
+                    }
+                    if(mode==2){
+                        unsigned clusterSize;
+                        cout<<"Pickup points per vehicle: ";
+                        cin>>clusterSize;
+                        vector<Service> clusters = clusterService(depotService,clusterSize);
+                        // the workers share the mapped image, unless roads were closed in the graph after loading it
+                        if(imageMatchesGraph(image,graph))
+                            routeClusters(clusters,image,0,cout);
+                        else
+                            routeClusters(clusters,StaticGraph(graph),0,cout);
+                        cout<<"Done!\n";
+                        continue;
+                    }
+                    RoutingContext context;
+                    context.profiles = &profiles;
+                    context.turns = &turns;
+                    context.ch = &ch;
+                    chooseRoutingOptions(context);
+                    proccessService(depotService,graph,context);
+                    cout<<"Done!\n";
+                    cout<<"Displaying service!\n";
+                    displayService(depotService, graph);
+                }
                 break;
         }
     }